@@ -0,0 +1,46 @@
+#pragma once
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.h>
+#include <future>
+#include <string>
+#include "buffer.hpp"
+#include "image.hpp"
+#include "shader_module.hpp"
+#include "worker_pool.hpp"
+
+namespace vka {
+// Each builder is copied into the task, so the caller may
+// keep reusing it. VMA serializes access internally unless
+// the allocator was created externally synchronized.
+inline auto build_async(
+    worker_pool& workers,
+    buffer_builder builder,
+    VmaAllocator allocator) {
+  return workers.submit([builder, allocator]() mutable {
+    return builder.build(allocator);
+  });
+}
+
+inline auto build_async(
+    worker_pool& workers,
+    image_builder builder,
+    VmaAllocator allocator) {
+  return workers.submit([builder, allocator]() mutable {
+    return builder.build(allocator);
+  });
+}
+
+// Reads the shader files and creates the module off the
+// calling thread.
+template <typename T>
+inline auto make_shader_async(
+    worker_pool& workers,
+    VkDevice device,
+    std::string name) {
+  return workers.submit(
+      [device, name = std::move(name)] {
+        return make_shader<T>(device, name);
+      });
+}
+}  // namespace vka
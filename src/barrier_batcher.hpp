@@ -0,0 +1,284 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <tl/expected.hpp>
+#include <vector>
+#include "sync_helper.hpp"
+
+namespace vka {
+struct barrier_stats {
+  uint64_t barriers = {};
+  uint64_t calls = {};
+};
+
+inline uint64_t range_end(
+    uint32_t first,
+    uint32_t count) noexcept {
+  return count == UINT32_MAX ? UINT64_MAX
+                             : uint64_t(first) + count;
+}
+
+inline bool ranges_overlap(
+    uint32_t firstA,
+    uint32_t countA,
+    uint32_t firstB,
+    uint32_t countB) noexcept {
+  return firstA < range_end(firstB, countB) &&
+         firstB < range_end(firstA, countA);
+}
+
+// VK_REMAINING_MIP_LEVELS and VK_REMAINING_ARRAY_LAYERS are
+// treated as reaching the end of the image.
+inline bool subresources_overlap(
+    const VkImageSubresourceRange& a,
+    const VkImageSubresourceRange& b) noexcept {
+  return (a.aspectMask & b.aspectMask) != 0 &&
+         ranges_overlap(
+             a.baseMipLevel,
+             a.levelCount,
+             b.baseMipLevel,
+             b.levelCount) &&
+         ranges_overlap(
+             a.baseArrayLayer,
+             a.layerCount,
+             b.baseArrayLayer,
+             b.layerCount);
+}
+
+#ifdef VK_KHR_synchronization2
+// Entry point of VK_KHR_synchronization2, which the loader
+// does not export directly.
+struct synchronization2_functions {
+  PFN_vkCmdPipelineBarrier2KHR pipelineBarrier2 = {};
+
+  static tl::expected<synchronization2_functions, VkResult>
+  load(VkDevice device) {
+    synchronization2_functions functions = {};
+    functions.pipelineBarrier2 =
+        reinterpret_cast<PFN_vkCmdPipelineBarrier2KHR>(
+            vkGetDeviceProcAddr(
+                device, "vkCmdPipelineBarrier2KHR"));
+    if (!functions.pipelineBarrier2) {
+      return tl::make_unexpected(
+          VK_ERROR_EXTENSION_NOT_PRESENT);
+    }
+    return functions;
+  }
+};
+#endif
+
+// Collects thsvs barriers for one command buffer and
+// records them as a single vkCmdPipelineBarrier with merged
+// stage masks. Call flush() right before the first command
+// that depends on them. An image barrier touching a
+// subresource that already has a pending barrier flushes
+// first, since two layout transitions of the same
+// subresource cannot share a call.
+struct barrier_batcher {
+  explicit barrier_batcher(VkCommandBuffer cmd)
+      : m_cmd(cmd) {}
+
+#ifdef VK_KHR_synchronization2
+  // Records with vkCmdPipelineBarrier2KHR instead. Each
+  // barrier keeps its own stage masks, so unrelated
+  // barriers in one call do not wait on each other's
+  // stages.
+  explicit barrier_batcher(
+      VkCommandBuffer cmd,
+      synchronization2_functions functions)
+      : m_cmd(cmd), m_functions(functions) {}
+#endif
+
+  void global(const ThsvsGlobalBarrier& barrier) {
+#ifdef VK_KHR_synchronization2
+    if (m_functions.pipelineBarrier2) {
+      VkMemoryBarrier2KHR memoryBarrier = {};
+      thsvsGetVulkanMemoryBarrier2(barrier, &memoryBarrier);
+      m_memoryBarriers2.push_back(memoryBarrier);
+      ++m_stats.barriers;
+      return;
+    }
+#endif
+    VkPipelineStageFlags srcStages = {};
+    VkPipelineStageFlags dstStages = {};
+    VkMemoryBarrier memoryBarrier = {};
+    thsvsGetVulkanMemoryBarrier(
+        barrier, &srcStages, &dstStages, &memoryBarrier);
+    m_memoryBarrier.srcAccessMask |=
+        memoryBarrier.srcAccessMask;
+    m_memoryBarrier.dstAccessMask |=
+        memoryBarrier.dstAccessMask;
+    m_hasMemoryBarrier = true;
+    add_stages(srcStages, dstStages);
+  }
+
+  void buffer(const ThsvsBufferBarrier& barrier) {
+#ifdef VK_KHR_synchronization2
+    if (m_functions.pipelineBarrier2) {
+      VkBufferMemoryBarrier2KHR bufferBarrier = {};
+      thsvsGetVulkanBufferMemoryBarrier2(
+          barrier, &bufferBarrier);
+      m_bufferBarriers2.push_back(bufferBarrier);
+      ++m_stats.barriers;
+      return;
+    }
+#endif
+    VkPipelineStageFlags srcStages = {};
+    VkPipelineStageFlags dstStages = {};
+    VkBufferMemoryBarrier bufferBarrier = {};
+    thsvsGetVulkanBufferMemoryBarrier(
+        barrier, &srcStages, &dstStages, &bufferBarrier);
+    m_bufferBarriers.push_back(bufferBarrier);
+    add_stages(srcStages, dstStages);
+  }
+
+  void image(const ThsvsImageBarrier& barrier) {
+    if (pending_image(barrier)) {
+      flush();
+    }
+#ifdef VK_KHR_synchronization2
+    if (m_functions.pipelineBarrier2) {
+      VkImageMemoryBarrier2KHR imageBarrier = {};
+      thsvsGetVulkanImageMemoryBarrier2(
+          barrier, &imageBarrier);
+      m_imageBarriers2.push_back(imageBarrier);
+      ++m_stats.barriers;
+      return;
+    }
+#endif
+    VkPipelineStageFlags srcStages = {};
+    VkPipelineStageFlags dstStages = {};
+    VkImageMemoryBarrier imageBarrier = {};
+    thsvsGetVulkanImageMemoryBarrier(
+        barrier, &srcStages, &dstStages, &imageBarrier);
+    m_imageBarriers.push_back(imageBarrier);
+    add_stages(srcStages, dstStages);
+  }
+
+  // Records every pending barrier; does nothing if there
+  // are none.
+  void flush() {
+    if (empty()) {
+      return;
+    }
+#ifdef VK_KHR_synchronization2
+    if (m_functions.pipelineBarrier2) {
+      flush2();
+      return;
+    }
+#endif
+    vkCmdPipelineBarrier(
+        m_cmd,
+        m_srcStages,
+        m_dstStages,
+        0,
+        m_hasMemoryBarrier ? 1 : 0,
+        m_hasMemoryBarrier ? &m_memoryBarrier : nullptr,
+        static_cast<uint32_t>(m_bufferBarriers.size()),
+        m_bufferBarriers.data(),
+        static_cast<uint32_t>(m_imageBarriers.size()),
+        m_imageBarriers.data());
+    ++m_stats.calls;
+    m_srcStages = {};
+    m_dstStages = {};
+    m_memoryBarrier = {VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    m_hasMemoryBarrier = {};
+    m_bufferBarriers.clear();
+    m_imageBarriers.clear();
+  }
+
+  bool empty() const noexcept {
+#ifdef VK_KHR_synchronization2
+    if (m_functions.pipelineBarrier2) {
+      return m_memoryBarriers2.empty() &&
+             m_bufferBarriers2.empty() &&
+             m_imageBarriers2.empty();
+    }
+#endif
+    return !m_hasMemoryBarrier &&
+           m_bufferBarriers.empty() &&
+           m_imageBarriers.empty();
+  }
+
+  barrier_stats stats() const noexcept { return m_stats; }
+
+  operator VkCommandBuffer() const noexcept {
+    return m_cmd;
+  }
+
+private:
+  bool pending_image(
+      const ThsvsImageBarrier& barrier) const noexcept {
+    auto overlaps = [&](const auto& pending) {
+      return pending.image == barrier.image &&
+             subresources_overlap(
+                 pending.subresourceRange,
+                 barrier.subresourceRange);
+    };
+    for (auto& pending : m_imageBarriers) {
+      if (overlaps(pending)) {
+        return true;
+      }
+    }
+#ifdef VK_KHR_synchronization2
+    for (auto& pending : m_imageBarriers2) {
+      if (overlaps(pending)) {
+        return true;
+      }
+    }
+#endif
+    return false;
+  }
+
+#ifdef VK_KHR_synchronization2
+  void flush2() {
+    VkDependencyInfoKHR dependencyInfo = {
+        VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR};
+    dependencyInfo.memoryBarrierCount =
+        static_cast<uint32_t>(m_memoryBarriers2.size());
+    dependencyInfo.pMemoryBarriers =
+        m_memoryBarriers2.data();
+    dependencyInfo.bufferMemoryBarrierCount =
+        static_cast<uint32_t>(m_bufferBarriers2.size());
+    dependencyInfo.pBufferMemoryBarriers =
+        m_bufferBarriers2.data();
+    dependencyInfo.imageMemoryBarrierCount =
+        static_cast<uint32_t>(m_imageBarriers2.size());
+    dependencyInfo.pImageMemoryBarriers =
+        m_imageBarriers2.data();
+    m_functions.pipelineBarrier2(m_cmd, &dependencyInfo);
+    ++m_stats.calls;
+    m_memoryBarriers2.clear();
+    m_bufferBarriers2.clear();
+    m_imageBarriers2.clear();
+  }
+#endif
+
+  void add_stages(
+      VkPipelineStageFlags srcStages,
+      VkPipelineStageFlags dstStages) noexcept {
+    m_srcStages |= srcStages;
+    m_dstStages |= dstStages;
+    ++m_stats.barriers;
+  }
+
+  VkCommandBuffer m_cmd = {};
+  VkPipelineStageFlags m_srcStages = {};
+  VkPipelineStageFlags m_dstStages = {};
+  VkMemoryBarrier m_memoryBarrier = {
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+  bool m_hasMemoryBarrier = {};
+  std::vector<VkBufferMemoryBarrier> m_bufferBarriers = {};
+  std::vector<VkImageMemoryBarrier> m_imageBarriers = {};
+#ifdef VK_KHR_synchronization2
+  synchronization2_functions m_functions = {};
+  std::vector<VkMemoryBarrier2KHR> m_memoryBarriers2 = {};
+  std::vector<VkBufferMemoryBarrier2KHR> m_bufferBarriers2 =
+      {};
+  std::vector<VkImageMemoryBarrier2KHR> m_imageBarriers2 =
+      {};
+#endif
+  barrier_stats m_stats = {};
+};
+}  // namespace vka
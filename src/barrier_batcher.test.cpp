@@ -0,0 +1,290 @@
+#include "barrier_batcher.hpp"
+
+#include <catch2/catch.hpp>
+#include "command_buffer.hpp"
+#include "command_pool.hpp"
+#include "device.hpp"
+#include "image.hpp"
+#include "instance.hpp"
+#include "memory_allocator.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue_family.hpp"
+
+using namespace vka;
+TEST_CASE("Subresource ranges overlap") {
+  VkImageSubresourceRange mip0 = {
+      VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+  VkImageSubresourceRange mip1 = {
+      VK_IMAGE_ASPECT_COLOR_BIT, 1, 1, 0, 1};
+  VkImageSubresourceRange allMips = {
+      VK_IMAGE_ASPECT_COLOR_BIT,
+      0,
+      VK_REMAINING_MIP_LEVELS,
+      0,
+      1};
+  REQUIRE(!subresources_overlap(mip0, mip1));
+  REQUIRE(subresources_overlap(mip1, allMips));
+  VkImageSubresourceRange depth = {
+      VK_IMAGE_ASPECT_DEPTH_BIT, 0, 1, 0, 1};
+  REQUIRE(!subresources_overlap(mip0, depth));
+}
+
+TEST_CASE("Barrier batcher merges barriers into one call") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<image> imagePtr = {};
+  image_builder{}
+      .gpu_only()
+      .format(VK_FORMAT_R8G8B8A8_UNORM)
+      .image_extent(64, 64)
+      .mip_levels(2)
+      .transfer_destination()
+      .sampled()
+      .type_2d()
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*allocatorPtr)
+      .map(move_into{imagePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<command_pool> commandPoolPtr = {};
+  command_pool_builder{}
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*devicePtr)
+      .map(move_into{commandPoolPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<command_buffer> commandPtr = {};
+  command_buffer_allocator{}
+      .set_command_pool(commandPoolPtr.get())
+      .allocate(*devicePtr)
+      .map(move_into{commandPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkCommandBufferBeginInfo beginInfo = {
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+  REQUIRE(
+      vkBeginCommandBuffer(*commandPtr, &beginInfo) ==
+      VK_SUCCESS);
+
+  ThsvsAccessType transferWrite =
+      THSVS_ACCESS_TRANSFER_WRITE;
+  ThsvsAccessType sampled =
+      THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+  ThsvsImageBarrier toTransfer = {};
+  toTransfer.nextAccessCount = 1;
+  toTransfer.pNextAccesses = &transferWrite;
+  toTransfer.prevLayout = THSVS_IMAGE_LAYOUT_OPTIMAL;
+  toTransfer.nextLayout = THSVS_IMAGE_LAYOUT_OPTIMAL;
+  toTransfer.discardContents = VK_TRUE;
+  toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  toTransfer.image = *imagePtr;
+  toTransfer.subresourceRange = {
+      VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+  barrier_batcher barriers{*commandPtr};
+  barriers.image(toTransfer);
+  toTransfer.subresourceRange.baseMipLevel = 1;
+  barriers.image(toTransfer);
+  REQUIRE(barriers.stats().calls == 0);
+  barriers.flush();
+  REQUIRE(barriers.stats().calls == 1);
+  REQUIRE(barriers.empty());
+
+  ThsvsImageBarrier toSampled = toTransfer;
+  toSampled.prevAccessCount = 1;
+  toSampled.pPrevAccesses = &transferWrite;
+  toSampled.pNextAccesses = &sampled;
+  toSampled.discardContents = VK_FALSE;
+  barriers.image(toSampled);
+  toSampled.subresourceRange.baseMipLevel = 0;
+  barriers.image(toSampled);
+  ThsvsGlobalBarrier global = {
+      1, &transferWrite, 1, &sampled};
+  barriers.global(global);
+  REQUIRE(barriers.stats().calls == 1);
+
+  // a second transition of mip 1 cannot share the call
+  barriers.image(toTransfer);
+  REQUIRE(barriers.stats().calls == 2);
+  barriers.flush();
+  barriers.flush();
+  REQUIRE(barriers.stats().calls == 3);
+  REQUIRE(barriers.stats().barriers == 6);
+  REQUIRE(vkEndCommandBuffer(*commandPtr) == VK_SUCCESS);
+}
+
+#ifdef VK_KHR_synchronization2
+TEST_CASE("Barrier batcher uses synchronization2") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .physical_device_properties2()
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  auto supported = synchronization2_supported(
+      *instancePtr, physicalDevice);
+  REQUIRE(supported);
+  if (!*supported) {
+    WARN("VK_KHR_synchronization2 is not supported");
+    return;
+  }
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .synchronization2()
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<image> imagePtr = {};
+  image_builder{}
+      .gpu_only()
+      .format(VK_FORMAT_R8G8B8A8_UNORM)
+      .image_extent(64, 64)
+      .mip_levels(2)
+      .transfer_destination()
+      .sampled()
+      .type_2d()
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*allocatorPtr)
+      .map(move_into{imagePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<command_pool> commandPoolPtr = {};
+  command_pool_builder{}
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*devicePtr)
+      .map(move_into{commandPoolPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<command_buffer> commandPtr = {};
+  command_buffer_allocator{}
+      .set_command_pool(commandPoolPtr.get())
+      .allocate(*devicePtr)
+      .map(move_into{commandPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkCommandBufferBeginInfo beginInfo = {
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+  REQUIRE(
+      vkBeginCommandBuffer(*commandPtr, &beginInfo) ==
+      VK_SUCCESS);
+
+  ThsvsAccessType transferWrite =
+      THSVS_ACCESS_TRANSFER_WRITE;
+  ThsvsAccessType sampled =
+      THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+  ThsvsImageBarrier toTransfer = {};
+  toTransfer.nextAccessCount = 1;
+  toTransfer.pNextAccesses = &transferWrite;
+  toTransfer.prevLayout = THSVS_IMAGE_LAYOUT_OPTIMAL;
+  toTransfer.nextLayout = THSVS_IMAGE_LAYOUT_OPTIMAL;
+  toTransfer.discardContents = VK_TRUE;
+  toTransfer.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  toTransfer.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  toTransfer.image = *imagePtr;
+  toTransfer.subresourceRange = {
+      VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+  synchronization2_functions functions = {};
+  synchronization2_functions::load(*devicePtr)
+      .map(move_into{functions})
+      .map_error([](auto error) { REQUIRE(false); });
+  barrier_batcher barriers{*commandPtr, functions};
+  barriers.image(toTransfer);
+  toTransfer.subresourceRange.baseMipLevel = 1;
+  barriers.image(toTransfer);
+  REQUIRE(barriers.stats().calls == 0);
+  barriers.flush();
+  REQUIRE(barriers.stats().calls == 1);
+  REQUIRE(barriers.empty());
+
+  ThsvsImageBarrier toSampled = toTransfer;
+  toSampled.prevAccessCount = 1;
+  toSampled.pPrevAccesses = &transferWrite;
+  toSampled.pNextAccesses = &sampled;
+  toSampled.discardContents = VK_FALSE;
+  barriers.image(toSampled);
+  toSampled.subresourceRange.baseMipLevel = 0;
+  barriers.image(toSampled);
+  ThsvsGlobalBarrier global = {
+      1, &transferWrite, 1, &sampled};
+  barriers.global(global);
+  REQUIRE(barriers.stats().calls == 1);
+
+  // a second transition of mip 1 cannot share the call
+  barriers.image(toTransfer);
+  REQUIRE(barriers.stats().calls == 2);
+  barriers.flush();
+  barriers.flush();
+  REQUIRE(barriers.stats().calls == 3);
+  REQUIRE(barriers.stats().barriers == 6);
+  REQUIRE(vkEndCommandBuffer(*commandPtr) == VK_SUCCESS);
+}
+#endif
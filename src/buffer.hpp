@@ -4,16 +4,27 @@
 #include <vulkan/vulkan.h>
 #include <memory>
 #include <tl/expected.hpp>
+#include "gsl-lite.hpp"
 
 namespace vka {
 struct buffer {
   explicit buffer(
       VmaAllocator allocator,
       VmaAllocation allocation,
-      VkBuffer bufferHandle)
+      VkBuffer bufferHandle,
+      VkDeviceSize bufferSize = {},
+      VkBufferUsageFlags bufferUsage = {},
+      uint32_t queueFamilyIndex = {},
+      void* persistentMapPtr = {},
+      bool hostCoherent = {})
       : m_allocator(allocator),
         m_allocation(allocation),
-        m_buffer(bufferHandle) {}
+        m_buffer(bufferHandle),
+        m_size(bufferSize),
+        m_usage(bufferUsage),
+        m_queueFamilyIndex(queueFamilyIndex),
+        m_persistentMapPtr(persistentMapPtr),
+        m_hostCoherent(hostCoherent) {}
 
   buffer(const buffer&) = delete;
   buffer(buffer&&) = default;
@@ -28,6 +39,9 @@ struct buffer {
   operator VmaAllocation() { return m_allocation; }
 
   tl::expected<void*, VkResult> map() noexcept {
+    if (m_persistentMapPtr != nullptr) {
+      return m_persistentMapPtr;
+    }
     if (!m_mapped) {
       auto result = vmaMapMemory(
           m_allocator, m_allocation, &m_mapPtr);
@@ -46,12 +60,97 @@ struct buffer {
     }
   }
 
+  VkDeviceSize size() const noexcept { return m_size; }
+
+  bool mapped() const noexcept { return m_mapped; }
+
+  bool persistently_mapped() const noexcept {
+    return m_persistentMapPtr != nullptr;
+  }
+
+  // Typed view of a persistent mapping; empty if the buffer
+  // was not built with persistently_mapped().
+  template <typename T>
+  gsl::span<T> mapped_span() const noexcept {
+    auto count = m_persistentMapPtr != nullptr
+                     ? m_size / sizeof(T)
+                     : 0;
+    return gsl::span<T>(
+        static_cast<T*>(m_persistentMapPtr),
+        static_cast<std::ptrdiff_t>(count));
+  }
+
+  // Host writes must be flushed before the device reads
+  // them, unless the memory is HOST_COHERENT.
+  void flush(
+      VkDeviceSize offset = 0,
+      VkDeviceSize size = VK_WHOLE_SIZE) noexcept {
+    if (!m_hostCoherent) {
+      vmaFlushAllocation(
+          m_allocator, m_allocation, offset, size);
+    }
+  }
+
+  // Device writes must be invalidated before the host reads
+  // them, unless the memory is HOST_COHERENT.
+  void invalidate(
+      VkDeviceSize offset = 0,
+      VkDeviceSize size = VK_WHOLE_SIZE) noexcept {
+    if (!m_hostCoherent) {
+      vmaInvalidateAllocation(
+          m_allocator, m_allocation, offset, size);
+    }
+  }
+
+  // Replaces the buffer handle with a new one bound to the
+  // allocation's current memory, after defragmentation
+  // has moved it. The old handle is destroyed.
+  tl::expected<void, VkResult> rebind(
+      VkDevice device) noexcept {
+    VkBufferCreateInfo bufferCreateInfo = {
+        VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+    bufferCreateInfo.usage = m_usage;
+    bufferCreateInfo.size = m_size;
+    bufferCreateInfo.sharingMode =
+        VK_SHARING_MODE_EXCLUSIVE;
+    bufferCreateInfo.queueFamilyIndexCount = 1;
+    bufferCreateInfo.pQueueFamilyIndices =
+        &m_queueFamilyIndex;
+
+    VkBuffer bufferHandle = {};
+    auto createResult = vkCreateBuffer(
+        device, &bufferCreateInfo, nullptr, &bufferHandle);
+    if (createResult != VK_SUCCESS) {
+      return tl::make_unexpected(createResult);
+    }
+    auto bindResult = vmaBindBufferMemory(
+        m_allocator, m_allocation, bufferHandle);
+    if (bindResult != VK_SUCCESS) {
+      vkDestroyBuffer(device, bufferHandle, nullptr);
+      return tl::make_unexpected(bindResult);
+    }
+    vkDestroyBuffer(device, m_buffer, nullptr);
+    m_buffer = bufferHandle;
+    if (m_persistentMapPtr != nullptr) {
+      VmaAllocationInfo allocationInfo = {};
+      vmaGetAllocationInfo(
+          m_allocator, m_allocation, &allocationInfo);
+      m_persistentMapPtr = allocationInfo.pMappedData;
+    }
+    return {};
+  }
+
 private:
   VmaAllocator m_allocator = {};
   VmaAllocation m_allocation = {};
   VkBuffer m_buffer = {};
+  VkDeviceSize m_size = {};
+  VkBufferUsageFlags m_usage = {};
+  uint32_t m_queueFamilyIndex = {};
   bool m_mapped = {};
   void* m_mapPtr = {};
+  void* m_persistentMapPtr = {};
+  bool m_hostCoherent = {};
 };
 
 struct buffer_builder {
@@ -73,6 +172,7 @@ struct buffer_builder {
     allocationCreateInfo.pool = m_memoryPool;
 
     VmaAllocation allocation = {};
+    VmaAllocationInfo allocationInfo = {};
     VkBuffer bufferHandle = {};
     auto result = vmaCreateBuffer(
         allocator,
@@ -80,13 +180,27 @@ struct buffer_builder {
         &allocationCreateInfo,
         &bufferHandle,
         &allocation,
-        nullptr);
+        &allocationInfo);
     if (result != VK_SUCCESS) {
       return tl::make_unexpected(result);
     }
 
+    VkMemoryPropertyFlags memoryFlags = {};
+    vmaGetMemoryTypeProperties(
+        allocator, allocationInfo.memoryType, &memoryFlags);
+    auto hostCoherent =
+        (memoryFlags &
+         VK_MEMORY_PROPERTY_HOST_COHERENT_BIT) != 0;
+
     return std::make_unique<buffer>(
-        allocator, allocation, bufferHandle);
+        allocator,
+        allocation,
+        bufferHandle,
+        m_bufferSize,
+        m_bufferUsage,
+        m_queueFamilyIndex,
+        allocationInfo.pMappedData,
+        hostCoherent);
   }
 
   buffer_builder& dedicated() {
@@ -95,6 +209,13 @@ struct buffer_builder {
     return *this;
   }
 
+  // Maps the buffer for its whole lifetime; requires a
+  // host visible memory usage such as cpu_to_gpu().
+  buffer_builder& persistently_mapped() {
+    m_allocationFlags |= VMA_ALLOCATION_CREATE_MAPPED_BIT;
+    return *this;
+  }
+
   buffer_builder& memory_pool(VmaPool memoryPool) {
     m_memoryPool = memoryPool;
     return *this;
@@ -61,4 +61,62 @@ TEST_CASE("Create a 1024b vertex buffer (gpu-local)") {
       .map_error([](auto error) { REQUIRE(false); });
   REQUIRE(bufferPtr->operator VkBuffer() != VK_NULL_HANDLE);
   REQUIRE(bufferPtr->operator VmaAllocation() != nullptr);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Create a persistently mapped uniform buffer") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<buffer> bufferPtr = {};
+  buffer_builder{}
+      .size(256)
+      .cpu_to_gpu()
+      .persistently_mapped()
+      .uniform_buffer()
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*allocatorPtr)
+      .map(move_into{bufferPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(bufferPtr->persistently_mapped());
+
+  auto floats = bufferPtr->mapped_span<float>();
+  REQUIRE(floats.size() == 256 / sizeof(float));
+  floats[0] = 1.f;
+  bufferPtr->flush(0, sizeof(float));
+  REQUIRE(*bufferPtr->map() == floats.data());
+}
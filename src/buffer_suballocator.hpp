@@ -0,0 +1,240 @@
+#pragma once
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.h>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <tl/expected.hpp>
+#include <tl/optional.hpp>
+#include "buffer.hpp"
+#include "ring_allocator.hpp"
+
+namespace vka {
+// Best-fit free list over a range of bytes. Freed ranges
+// are merged with their free neighbours.
+struct free_list_range {
+  struct range {
+    VkDeviceSize offset = {};
+    VkDeviceSize size = {};
+  };
+
+  explicit free_list_range(VkDeviceSize capacity)
+      : m_capacity(capacity) {
+    insert_free(0, capacity);
+  }
+
+  // Alignment need not be a power of two, so a vertex
+  // stride can be used directly.
+  tl::optional<range> allocate(
+      VkDeviceSize size,
+      VkDeviceSize alignment) {
+    if (size == 0) {
+      return {};
+    }
+    for (auto it = m_freeBySize.lower_bound(size);
+         it != m_freeBySize.end();
+         ++it) {
+      auto freeOffset = it->second;
+      auto freeSize = it->first;
+      auto offset = align_up(freeOffset, alignment);
+      auto padding = offset - freeOffset;
+      if (padding + size > freeSize) {
+        continue;
+      }
+      m_freeBySize.erase(it);
+      m_freeByOffset.erase(freeOffset);
+      if (padding > 0) {
+        insert_free(freeOffset, padding);
+      }
+      auto remainder = freeSize - padding - size;
+      if (remainder > 0) {
+        insert_free(offset + size, remainder);
+      }
+      m_used += size;
+      return range{offset, size};
+    }
+    return {};
+  }
+
+  void free(range allocation) {
+    auto offset = allocation.offset;
+    auto size = allocation.size;
+    m_used -= size;
+
+    auto next = m_freeByOffset.lower_bound(offset);
+    if (next != m_freeByOffset.end() &&
+        next->first == offset + size) {
+      size += next->second;
+      erase_free(next);
+    }
+    next = m_freeByOffset.lower_bound(offset);
+    if (next != m_freeByOffset.begin()) {
+      auto previous = std::prev(next);
+      if (previous->first + previous->second == offset) {
+        offset = previous->first;
+        size += previous->second;
+        erase_free(previous);
+      }
+    }
+    insert_free(offset, size);
+  }
+
+  VkDeviceSize used() const noexcept { return m_used; }
+
+  VkDeviceSize capacity() const noexcept {
+    return m_capacity;
+  }
+
+  size_t free_range_count() const noexcept {
+    return m_freeByOffset.size();
+  }
+
+private:
+  void insert_free(VkDeviceSize offset, VkDeviceSize size) {
+    m_freeByOffset.emplace(offset, size);
+    m_freeBySize.emplace(size, offset);
+  }
+
+  void erase_free(
+      std::map<VkDeviceSize, VkDeviceSize>::iterator it) {
+    auto sizeRange = m_freeBySize.equal_range(it->second);
+    for (auto sizeIt = sizeRange.first;
+         sizeIt != sizeRange.second;
+         ++sizeIt) {
+      if (sizeIt->second == it->first) {
+        m_freeBySize.erase(sizeIt);
+        break;
+      }
+    }
+    m_freeByOffset.erase(it);
+  }
+
+  VkDeviceSize m_capacity = {};
+  VkDeviceSize m_used = {};
+  std::map<VkDeviceSize, VkDeviceSize> m_freeByOffset = {};
+  std::multimap<VkDeviceSize, VkDeviceSize> m_freeBySize =
+      {};
+};
+
+struct buffer_slice {
+  VkBuffer buffer = {};
+  VkDeviceSize offset = {};
+  VkDeviceSize size = {};
+
+  // Index of the slice's first element, for use as a
+  // vertexOffset or firstIndex. The slice must have been
+  // allocated with stride as its alignment.
+  uint32_t first_element(
+      VkDeviceSize stride) const noexcept {
+    return static_cast<uint32_t>(offset / stride);
+  }
+};
+
+struct suballocator_out_of_space {};
+
+// Hands out slices of one large buffer, so many meshes can
+// share a single bind.
+struct buffer_suballocator {
+  explicit buffer_suballocator(
+      std::unique_ptr<buffer> bufferPtr,
+      VkDeviceSize capacity)
+      : m_buffer(std::move(bufferPtr)), m_range(capacity) {}
+
+  buffer_suballocator(const buffer_suballocator&) = delete;
+  buffer_suballocator(buffer_suballocator&&) = default;
+  buffer_suballocator& operator=(
+      const buffer_suballocator&) = delete;
+  buffer_suballocator& operator=(buffer_suballocator&&) =
+      default;
+
+  operator VkBuffer() { return *m_buffer; }
+
+  tl::expected<buffer_slice, suballocator_out_of_space>
+  allocate(VkDeviceSize size, VkDeviceSize alignment = 1) {
+    auto allocation = m_range.allocate(size, alignment);
+    if (!allocation) {
+      return tl::make_unexpected(
+          suballocator_out_of_space{});
+    }
+    return buffer_slice{
+        *m_buffer, allocation->offset, allocation->size};
+  }
+
+  // The slice must no longer be in use by the device.
+  void free(buffer_slice slice) {
+    m_range.free({slice.offset, slice.size});
+  }
+
+  VkDeviceSize used() const noexcept {
+    return m_range.used();
+  }
+
+  VkDeviceSize capacity() const noexcept {
+    return m_range.capacity();
+  }
+
+private:
+  std::unique_ptr<buffer> m_buffer = {};
+  free_list_range m_range;
+};
+
+struct buffer_suballocator_builder {
+  tl::expected<
+      std::unique_ptr<buffer_suballocator>,
+      VkResult>
+  build(VmaAllocator allocator) {
+    auto bufferResult = m_bufferBuilder.size(m_size)
+                            .gpu_only()
+                            .transfer_destination()
+                            .build(allocator);
+    if (!bufferResult) {
+      return tl::make_unexpected(bufferResult.error());
+    }
+    return std::make_unique<buffer_suballocator>(
+        std::move(*bufferResult), m_size);
+  }
+
+  buffer_suballocator_builder& size(
+      VkDeviceSize bufferSize) {
+    m_size = bufferSize;
+    return *this;
+  }
+
+  buffer_suballocator_builder& vertex_buffer() {
+    m_bufferBuilder.vertex_buffer();
+    return *this;
+  }
+
+  buffer_suballocator_builder& index_buffer() {
+    m_bufferBuilder.index_buffer();
+    return *this;
+  }
+
+  buffer_suballocator_builder& storage_buffer() {
+    m_bufferBuilder.storage_buffer();
+    return *this;
+  }
+
+  buffer_suballocator_builder& indirect_buffer() {
+    m_bufferBuilder.indirect_buffer();
+    return *this;
+  }
+
+  buffer_suballocator_builder& queue_family_index(
+      uint32_t index) {
+    m_bufferBuilder.queue_family_index(index);
+    return *this;
+  }
+
+  buffer_suballocator_builder& memory_pool(
+      VmaPool memoryPool) {
+    m_bufferBuilder.memory_pool(memoryPool);
+    return *this;
+  }
+
+private:
+  buffer_builder m_bufferBuilder = {};
+  VkDeviceSize m_size = {};
+};
+}  // namespace vka
@@ -0,0 +1,122 @@
+#include "buffer_suballocator.hpp"
+
+#include <catch2/catch.hpp>
+#include "device.hpp"
+#include "instance.hpp"
+#include "memory_allocator.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue_family.hpp"
+
+using namespace vka;
+TEST_CASE("Free list picks the best fitting range") {
+  free_list_range range{1024};
+  auto a = range.allocate(100, 1);
+  auto b = range.allocate(300, 1);
+  auto c = range.allocate(50, 1);
+  REQUIRE(a);
+  REQUIRE(b);
+  REQUIRE(c);
+  range.free(*a);
+  auto d = range.allocate(80, 1);
+  REQUIRE(d);
+  REQUIRE(d->offset == 0);
+  REQUIRE(range.used() == 80 + 300 + 50);
+}
+
+TEST_CASE("Free list aligns to a vertex stride") {
+  free_list_range range{1024};
+  REQUIRE(range.allocate(10, 1));
+  auto vertices = range.allocate(24, 12);
+  REQUIRE(vertices);
+  REQUIRE(vertices->offset == 12);
+  REQUIRE(range.free_range_count() == 2);
+}
+
+TEST_CASE("Free list merges neighbouring ranges") {
+  free_list_range range{256};
+  auto a = range.allocate(64, 1);
+  auto b = range.allocate(64, 1);
+  auto c = range.allocate(64, 1);
+  range.free(*a);
+  range.free(*c);
+  REQUIRE(range.free_range_count() == 2);
+  range.free(*b);
+  REQUIRE(range.free_range_count() == 1);
+  REQUIRE(range.used() == 0);
+  auto whole = range.allocate(256, 1);
+  REQUIRE(whole);
+  REQUIRE(whole->offset == 0);
+}
+
+TEST_CASE("Free list fails when no range fits") {
+  free_list_range range{256};
+  REQUIRE(range.allocate(200, 1));
+  REQUIRE(!range.allocate(100, 1));
+}
+
+TEST_CASE("Suballocate meshes from one vertex buffer") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<buffer_suballocator> meshBufferPtr = {};
+  buffer_suballocator_builder{}
+      .size(1024 * 1024)
+      .vertex_buffer()
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*allocatorPtr)
+      .map(move_into{meshBufferPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  constexpr VkDeviceSize stride = 32;
+  buffer_slice first = {};
+  meshBufferPtr->allocate(stride * 3, stride)
+      .map(move_into{first})
+      .map_error([](auto error) { REQUIRE(false); });
+  buffer_slice second = {};
+  meshBufferPtr->allocate(stride * 6, stride)
+      .map(move_into{second})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(first.buffer == second.buffer);
+  REQUIRE(second.first_element(stride) == 3);
+
+  meshBufferPtr->free(first);
+  meshBufferPtr->free(second);
+  REQUIRE(meshBufferPtr->used() == 0);
+}
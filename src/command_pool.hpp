@@ -40,6 +40,10 @@ struct command_pool_builder {
         m_canResetBuffers
             ? VK_COMMAND_POOL_CREATE_RESET_COMMAND_BUFFER_BIT
             : 0;
+    if (m_transient) {
+      createInfo.flags |=
+          VK_COMMAND_POOL_CREATE_TRANSIENT_BIT;
+    }
 
     VkCommandPool pool = {};
     auto result = vkCreateCommandPool(
@@ -62,8 +66,16 @@ struct command_pool_builder {
     return *this;
   }
 
+  // Hint that buffers are short lived and the whole pool
+  // is reset at once.
+  command_pool_builder& transient() {
+    m_transient = true;
+    return *this;
+  }
+
 private:
   uint32_t m_queueFamilyIndex = {};
   bool m_canResetBuffers = {};
+  bool m_transient = {};
 };
 }  // namespace vka
\ No newline at end of file
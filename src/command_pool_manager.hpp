@@ -0,0 +1,202 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <memory>
+#include <tl/expected.hpp>
+#include <vector>
+#include "command_pool.hpp"
+
+namespace vka {
+// A transient command pool whose buffers are allocated in
+// batches and recycled all at once by reset().
+struct frame_command_pool {
+  explicit frame_command_pool(
+      VkDevice device,
+      std::unique_ptr<command_pool> poolPtr,
+      uint32_t batchSize)
+      : m_device(device),
+        m_pool(std::move(poolPtr)),
+        m_batchSize(batchSize) {}
+
+  frame_command_pool(const frame_command_pool&) = delete;
+  frame_command_pool(frame_command_pool&&) = default;
+  frame_command_pool& operator=(
+      const frame_command_pool&) = delete;
+  frame_command_pool& operator=(frame_command_pool&&) =
+      default;
+
+  tl::expected<VkCommandBuffer, VkResult> acquire(
+      VkCommandBufferLevel level) {
+    auto& buffers =
+        level == VK_COMMAND_BUFFER_LEVEL_PRIMARY
+            ? m_primary
+            : m_secondary;
+    if (buffers.next == buffers.handles.size()) {
+      auto oldSize = buffers.handles.size();
+      buffers.handles.resize(oldSize + m_batchSize);
+
+      VkCommandBufferAllocateInfo allocateInfo = {
+          VK_STRUCTURE_TYPE_COMMAND_BUFFER_ALLOCATE_INFO};
+      allocateInfo.commandPool = *m_pool;
+      allocateInfo.level = level;
+      allocateInfo.commandBufferCount = m_batchSize;
+      auto result = vkAllocateCommandBuffers(
+          m_device,
+          &allocateInfo,
+          buffers.handles.data() + oldSize);
+      if (result != VK_SUCCESS) {
+        buffers.handles.resize(oldSize);
+        return tl::make_unexpected(result);
+      }
+    }
+    return buffers.handles[buffers.next++];
+  }
+
+  // Every buffer acquired since the last reset must have
+  // finished executing.
+  tl::expected<void, VkResult> reset() {
+    auto result = vkResetCommandPool(m_device, *m_pool, 0);
+    if (result != VK_SUCCESS) {
+      return tl::make_unexpected(result);
+    }
+    m_primary.next = 0;
+    m_secondary.next = 0;
+    return {};
+  }
+
+  size_t allocated_count() const noexcept {
+    return m_primary.handles.size() +
+           m_secondary.handles.size();
+  }
+
+private:
+  struct buffer_list {
+    std::vector<VkCommandBuffer> handles = {};
+    size_t next = {};
+  };
+
+  VkDevice m_device = {};
+  std::unique_ptr<command_pool> m_pool = {};
+  uint32_t m_batchSize = {};
+  buffer_list m_primary = {};
+  buffer_list m_secondary = {};
+};
+
+// One frame_command_pool per (thread, frame in flight).
+// Each thread only touches its own pools, so no locking is
+// needed.
+struct command_pool_manager {
+  explicit command_pool_manager(
+      std::vector<frame_command_pool> pools,
+      uint32_t threadCount,
+      uint32_t frameCount)
+      : m_pools(std::move(pools)),
+        m_threadCount(threadCount),
+        m_frameCount(frameCount) {}
+
+  command_pool_manager(const command_pool_manager&) =
+      delete;
+  command_pool_manager(command_pool_manager&&) = default;
+  command_pool_manager& operator=(
+      const command_pool_manager&) = delete;
+  command_pool_manager& operator=(command_pool_manager&&) =
+      default;
+
+  // Recycles every thread's pool for frameIndex and makes
+  // it current. Call once the fence of the previous use of
+  // frameIndex has signaled.
+  tl::expected<void, VkResult> begin_frame(
+      uint32_t frameIndex) {
+    m_frameIndex = frameIndex % m_frameCount;
+    for (uint32_t thread = {}; thread < m_threadCount;
+         ++thread) {
+      auto result = pool(thread).reset();
+      if (!result) {
+        return result;
+      }
+    }
+    return {};
+  }
+
+  tl::expected<VkCommandBuffer, VkResult> acquire(
+      uint32_t threadIndex,
+      VkCommandBufferLevel level =
+          VK_COMMAND_BUFFER_LEVEL_PRIMARY) {
+    return pool(threadIndex).acquire(level);
+  }
+
+  uint32_t thread_count() const noexcept {
+    return m_threadCount;
+  }
+
+  uint32_t frame_count() const noexcept {
+    return m_frameCount;
+  }
+
+private:
+  frame_command_pool& pool(uint32_t threadIndex) {
+    return m_pools[m_frameIndex * m_threadCount +
+                   threadIndex];
+  }
+
+  std::vector<frame_command_pool> m_pools = {};
+  uint32_t m_threadCount = {};
+  uint32_t m_frameCount = {};
+  uint32_t m_frameIndex = {};
+};
+
+struct command_pool_manager_builder {
+  tl::expected<
+      std::unique_ptr<command_pool_manager>,
+      VkResult>
+  build(VkDevice device) {
+    std::vector<frame_command_pool> pools = {};
+    for (uint32_t i = {}; i < m_threadCount * m_frameCount;
+         ++i) {
+      auto poolResult =
+          command_pool_builder{}
+              .queue_family_index(m_queueFamilyIndex)
+              .transient()
+              .build(device);
+      if (!poolResult) {
+        return tl::make_unexpected(poolResult.error());
+      }
+      pools.emplace_back(
+          device, std::move(*poolResult), m_batchSize);
+    }
+    return std::make_unique<command_pool_manager>(
+        std::move(pools), m_threadCount, m_frameCount);
+  }
+
+  command_pool_manager_builder& queue_family_index(
+      uint32_t index) {
+    m_queueFamilyIndex = index;
+    return *this;
+  }
+
+  command_pool_manager_builder& thread_count(
+      uint32_t count) {
+    m_threadCount = count;
+    return *this;
+  }
+
+  command_pool_manager_builder& frames_in_flight(
+      uint32_t count) {
+    m_frameCount = count;
+    return *this;
+  }
+
+  // Number of command buffers allocated at a time when a
+  // pool runs out.
+  command_pool_manager_builder& batch_size(uint32_t count) {
+    m_batchSize = count;
+    return *this;
+  }
+
+private:
+  uint32_t m_queueFamilyIndex = {};
+  uint32_t m_threadCount = 1;
+  uint32_t m_frameCount = 2;
+  uint32_t m_batchSize = 8;
+};
+}  // namespace vka
@@ -0,0 +1,71 @@
+#include "command_pool_manager.hpp"
+
+#include <catch2/catch.hpp>
+#include "device.hpp"
+#include "instance.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue_family.hpp"
+
+using namespace vka;
+TEST_CASE("Recycle command buffers per frame") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<command_pool_manager> managerPtr = {};
+  command_pool_manager_builder{}
+      .queue_family_index(queueFamily.familyIndex)
+      .thread_count(2)
+      .frames_in_flight(2)
+      .batch_size(4)
+      .build(*devicePtr)
+      .map(move_into{managerPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  REQUIRE(managerPtr->begin_frame(0));
+  VkCommandBuffer first = {};
+  managerPtr->acquire(0)
+      .map(move_into{first})
+      .map_error([](auto error) { REQUIRE(false); });
+  VkCommandBuffer second = {};
+  managerPtr->acquire(0)
+      .map(move_into{second})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(first != second);
+
+  REQUIRE(managerPtr->begin_frame(1));
+  REQUIRE(managerPtr->begin_frame(0));
+  VkCommandBuffer recycled = {};
+  managerPtr->acquire(0)
+      .map(move_into{recycled})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(recycled == first);
+}
@@ -0,0 +1,304 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include "gsl-lite.hpp"
+
+namespace vka {
+struct recorder_stats {
+  uint64_t emitted = {};
+  uint64_t elided = {};
+};
+
+// Wraps a command buffer and skips bind and dynamic state
+// calls that would not change the bound state. Assumes
+// every pipeline declares viewport and scissor dynamic;
+// call invalidate() after binding one that does not, or
+// after anything else that disturbs state behind the
+// recorder's back.
+struct command_recorder {
+  static constexpr size_t max_descriptor_sets = 8;
+  static constexpr size_t max_vertex_bindings = 16;
+  static constexpr size_t max_push_constant_bytes = 256;
+
+  explicit command_recorder(VkCommandBuffer cmd)
+      : m_cmd(cmd) {}
+
+  operator VkCommandBuffer() const noexcept {
+    return m_cmd;
+  }
+
+  void bind_pipeline(
+      VkPipelineBindPoint bindPoint,
+      VkPipeline pipeline) {
+    auto& state = bind_point(bindPoint);
+    if (state.pipeline == pipeline) {
+      ++m_stats.elided;
+      return;
+    }
+    state.pipeline = pipeline;
+    vkCmdBindPipeline(m_cmd, bindPoint, pipeline);
+    ++m_stats.emitted;
+  }
+
+  // Calls with dynamic offsets are always emitted.
+  void bind_descriptor_sets(
+      VkPipelineBindPoint bindPoint,
+      VkPipelineLayout layout,
+      uint32_t firstSet,
+      gsl::span<const VkDescriptorSet> sets,
+      gsl::span<const uint32_t> dynamicOffsets = {}) {
+    auto& state = bind_point(bindPoint);
+    auto lastSet = firstSet + sets.size();
+    auto cacheable = lastSet <= max_descriptor_sets;
+    if (cacheable && dynamicOffsets.empty() &&
+        state.layout == layout &&
+        std::equal(
+            sets.begin(),
+            sets.end(),
+            state.sets.begin() + firstSet)) {
+      ++m_stats.elided;
+      return;
+    }
+
+    if (state.layout != layout) {
+      state.sets.fill(VK_NULL_HANDLE);
+      state.layout = layout;
+    }
+    if (cacheable) {
+      std::copy(
+          sets.begin(),
+          sets.end(),
+          state.sets.begin() + firstSet);
+      if (!dynamicOffsets.empty()) {
+        // offsets are not cached, so force the next call
+        std::fill(
+            state.sets.begin() + firstSet,
+            state.sets.begin() + lastSet,
+            VK_NULL_HANDLE);
+      }
+    } else if (firstSet < max_descriptor_sets) {
+      // the call also replaces the cached sets it reaches
+      std::fill(
+          state.sets.begin() + firstSet,
+          state.sets.end(),
+          VK_NULL_HANDLE);
+    }
+    vkCmdBindDescriptorSets(
+        m_cmd,
+        bindPoint,
+        layout,
+        firstSet,
+        static_cast<uint32_t>(sets.size()),
+        sets.data(),
+        static_cast<uint32_t>(dynamicOffsets.size()),
+        dynamicOffsets.data());
+    ++m_stats.emitted;
+  }
+
+  void bind_vertex_buffers(
+      uint32_t firstBinding,
+      gsl::span<const VkBuffer> buffers,
+      gsl::span<const VkDeviceSize> offsets) {
+    auto lastBinding = firstBinding + buffers.size();
+    auto cacheable = lastBinding <= max_vertex_bindings;
+    if (cacheable) {
+      auto unchanged = true;
+      for (size_t i = {}; i < buffers.size(); ++i) {
+        auto& bound = m_vertexBuffers[firstBinding + i];
+        unchanged = unchanged &&
+                    bound.buffer == buffers[i] &&
+                    bound.offset == offsets[i];
+        bound = {buffers[i], offsets[i]};
+      }
+      if (unchanged) {
+        ++m_stats.elided;
+        return;
+      }
+    } else if (firstBinding < max_vertex_bindings) {
+      std::fill(
+          m_vertexBuffers.begin() + firstBinding,
+          m_vertexBuffers.end(),
+          bound_buffer{});
+    }
+    vkCmdBindVertexBuffers(
+        m_cmd,
+        firstBinding,
+        static_cast<uint32_t>(buffers.size()),
+        buffers.data(),
+        offsets.data());
+    ++m_stats.emitted;
+  }
+
+  void bind_index_buffer(
+      VkBuffer buffer,
+      VkDeviceSize offset,
+      VkIndexType indexType) {
+    if (m_indexBuffer.buffer == buffer &&
+        m_indexBuffer.offset == offset &&
+        m_indexType == indexType) {
+      ++m_stats.elided;
+      return;
+    }
+    m_indexBuffer = {buffer, offset};
+    m_indexType = indexType;
+    vkCmdBindIndexBuffer(m_cmd, buffer, offset, indexType);
+    ++m_stats.emitted;
+  }
+
+  void push_constants(
+      VkPipelineLayout layout,
+      VkShaderStageFlags stages,
+      uint32_t offset,
+      gsl::span<const gsl::byte> data) {
+    auto size = static_cast<uint32_t>(data.size());
+    auto end = offset + size;
+    auto cached = layout == m_pushLayout &&
+                  stages == m_pushStages &&
+                  offset >= m_pushBegin && end <= m_pushEnd;
+    if (cached && std::memcmp(
+                      m_pushData.data() + offset,
+                      data.data(),
+                      size) == 0) {
+      ++m_stats.elided;
+      return;
+    }
+
+    if (end <= max_push_constant_bytes) {
+      if (layout != m_pushLayout ||
+          stages != m_pushStages || end < m_pushBegin ||
+          offset > m_pushEnd) {
+        m_pushLayout = layout;
+        m_pushStages = stages;
+        m_pushBegin = offset;
+        m_pushEnd = end;
+      } else {
+        m_pushBegin = std::min(m_pushBegin, offset);
+        m_pushEnd = std::max(m_pushEnd, end);
+      }
+      std::memcpy(
+          m_pushData.data() + offset, data.data(), size);
+    } else {
+      m_pushLayout = {};
+      m_pushBegin = {};
+      m_pushEnd = {};
+    }
+    vkCmdPushConstants(
+        m_cmd, layout, stages, offset, size, data.data());
+    ++m_stats.emitted;
+  }
+
+  void set_viewport(const VkViewport& viewport) {
+    if (m_viewportValid &&
+        same_bytes(m_viewport, viewport)) {
+      ++m_stats.elided;
+      return;
+    }
+    m_viewport = viewport;
+    m_viewportValid = true;
+    vkCmdSetViewport(m_cmd, 0, 1, &viewport);
+    ++m_stats.emitted;
+  }
+
+  void set_scissor(const VkRect2D& scissor) {
+    if (m_scissorValid && same_bytes(m_scissor, scissor)) {
+      ++m_stats.elided;
+      return;
+    }
+    m_scissor = scissor;
+    m_scissorValid = true;
+    vkCmdSetScissor(m_cmd, 0, 1, &scissor);
+    ++m_stats.emitted;
+  }
+
+  void draw(
+      uint32_t vertexCount,
+      uint32_t instanceCount = 1,
+      uint32_t firstVertex = 0,
+      uint32_t firstInstance = 0) {
+    vkCmdDraw(
+        m_cmd,
+        vertexCount,
+        instanceCount,
+        firstVertex,
+        firstInstance);
+  }
+
+  void draw_indexed(
+      uint32_t indexCount,
+      uint32_t instanceCount = 1,
+      uint32_t firstIndex = 0,
+      int32_t vertexOffset = 0,
+      uint32_t firstInstance = 0) {
+    vkCmdDrawIndexed(
+        m_cmd,
+        indexCount,
+        instanceCount,
+        firstIndex,
+        vertexOffset,
+        firstInstance);
+  }
+
+  // Forgets all cached state; the next call of each kind
+  // is always emitted.
+  void invalidate() noexcept {
+    m_bindPoints = {};
+    m_vertexBuffers = {};
+    m_indexBuffer = {};
+    m_indexType = {};
+    m_pushLayout = {};
+    m_pushStages = {};
+    m_pushBegin = {};
+    m_pushEnd = {};
+    m_viewportValid = {};
+    m_scissorValid = {};
+  }
+
+  recorder_stats stats() const noexcept { return m_stats; }
+
+private:
+  struct bind_point_state {
+    VkPipeline pipeline = {};
+    VkPipelineLayout layout = {};
+    std::array<VkDescriptorSet, max_descriptor_sets> sets =
+        {};
+  };
+
+  struct bound_buffer {
+    VkBuffer buffer = {};
+    VkDeviceSize offset = {};
+  };
+
+  bind_point_state& bind_point(
+      VkPipelineBindPoint bindPoint) {
+    auto isCompute =
+        bindPoint == VK_PIPELINE_BIND_POINT_COMPUTE;
+    return m_bindPoints[isCompute ? 1 : 0];
+  }
+
+  template <typename T>
+  static bool same_bytes(const T& a, const T& b) noexcept {
+    return std::memcmp(&a, &b, sizeof(T)) == 0;
+  }
+
+  VkCommandBuffer m_cmd = {};
+  recorder_stats m_stats = {};
+  std::array<bind_point_state, 2> m_bindPoints = {};
+  std::array<bound_buffer, max_vertex_bindings>
+      m_vertexBuffers = {};
+  bound_buffer m_indexBuffer = {};
+  VkIndexType m_indexType = {};
+  VkPipelineLayout m_pushLayout = {};
+  VkShaderStageFlags m_pushStages = {};
+  uint32_t m_pushBegin = {};
+  uint32_t m_pushEnd = {};
+  std::array<gsl::byte, max_push_constant_bytes>
+      m_pushData = {};
+  VkViewport m_viewport = {};
+  bool m_viewportValid = {};
+  VkRect2D m_scissor = {};
+  bool m_scissorValid = {};
+};
+}  // namespace vka
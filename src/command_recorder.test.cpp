@@ -0,0 +1,198 @@
+#include "command_recorder.hpp"
+
+#include <array>
+#include <catch2/catch.hpp>
+#include "buffer.hpp"
+#include "command_buffer.hpp"
+#include "command_pool.hpp"
+#include "device.hpp"
+#include "instance.hpp"
+#include "memory_allocator.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue_family.hpp"
+
+using namespace vka;
+TEST_CASE("Command recorder elides redundant state") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<buffer> bufferPtr = {};
+  buffer_builder{}
+      .size(1024)
+      .gpu_only()
+      .vertex_buffer()
+      .index_buffer()
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*allocatorPtr)
+      .map(move_into{bufferPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<command_pool> commandPoolPtr = {};
+  command_pool_builder{}
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*devicePtr)
+      .map(move_into{commandPoolPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<command_buffer> commandPtr = {};
+  command_buffer_allocator{}
+      .set_command_pool(commandPoolPtr.get())
+      .allocate(*devicePtr)
+      .map(move_into{commandPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkCommandBufferBeginInfo beginInfo = {
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+  REQUIRE(
+      vkBeginCommandBuffer(*commandPtr, &beginInfo) ==
+      VK_SUCCESS);
+
+  command_recorder recorder{*commandPtr};
+  VkViewport viewport = {0.f, 0.f, 100.f, 100.f, 0.f, 1.f};
+  VkRect2D scissor = {{0, 0}, {100, 100}};
+  std::array<VkBuffer, 1> vertexBuffers = {*bufferPtr};
+  std::array<VkDeviceSize, 1> vertexOffsets = {0};
+  for (int i = {}; i < 3; ++i) {
+    recorder.set_viewport(viewport);
+    recorder.set_scissor(scissor);
+    recorder.bind_vertex_buffers(
+        0, vertexBuffers, vertexOffsets);
+    recorder.bind_index_buffer(
+        *bufferPtr, 512, VK_INDEX_TYPE_UINT16);
+  }
+  REQUIRE(recorder.stats().emitted == 4);
+  REQUIRE(recorder.stats().elided == 8);
+
+  viewport.width = 50.f;
+  recorder.set_viewport(viewport);
+  recorder.invalidate();
+  recorder.set_scissor(scissor);
+  REQUIRE(recorder.stats().emitted == 6);
+  REQUIRE(vkEndCommandBuffer(*commandPtr) == VK_SUCCESS);
+}
+
+TEST_CASE("Command recorder clears overwritten cache") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<buffer> bufferPtr = {};
+  buffer_builder{}
+      .size(1024)
+      .gpu_only()
+      .vertex_buffer()
+      .index_buffer()
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*allocatorPtr)
+      .map(move_into{bufferPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<command_pool> commandPoolPtr = {};
+  command_pool_builder{}
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*devicePtr)
+      .map(move_into{commandPoolPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<command_buffer> commandPtr = {};
+  command_buffer_allocator{}
+      .set_command_pool(commandPoolPtr.get())
+      .allocate(*devicePtr)
+      .map(move_into{commandPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkCommandBufferBeginInfo beginInfo = {
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+  REQUIRE(
+      vkBeginCommandBuffer(*commandPtr, &beginInfo) ==
+      VK_SUCCESS);
+
+  command_recorder recorder{*commandPtr};
+  auto last = static_cast<uint32_t>(
+      command_recorder::max_vertex_bindings - 1);
+  std::array<VkBuffer, 2> vertexBuffers = {
+      *bufferPtr, *bufferPtr};
+  std::array<VkDeviceSize, 2> vertexOffsets = {0, 0};
+  std::array<VkDeviceSize, 2> movedOffsets = {256, 256};
+  recorder.bind_vertex_buffers(
+      last, {vertexBuffers.data(), 1}, vertexOffsets);
+  // reaches past the cached bindings and replaces the last
+  recorder.bind_vertex_buffers(
+      last, vertexBuffers, movedOffsets);
+  recorder.bind_vertex_buffers(
+      last, {vertexBuffers.data(), 1}, vertexOffsets);
+  REQUIRE(recorder.stats().emitted == 3);
+  REQUIRE(recorder.stats().elided == 0);
+  REQUIRE(vkEndCommandBuffer(*commandPtr) == VK_SUCCESS);
+}
@@ -0,0 +1,318 @@
+#pragma once
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <functional>
+#include <memory>
+#include <tl/expected.hpp>
+#include <vector>
+#include "buffer.hpp"
+#include "image.hpp"
+
+namespace vka {
+// A descriptor that refers to a movable buffer. It is
+// rewritten with the new buffer handle whenever the buffer
+// is moved.
+struct descriptor_buffer_write {
+  VkDescriptorSet set = {};
+  uint32_t binding = {};
+  uint32_t arrayElement = {};
+  VkDescriptorType type = {};
+  VkDeviceSize offset = {};
+  VkDeviceSize range = VK_WHOLE_SIZE;
+};
+
+struct defragmentation_stats {
+  VkDeviceSize bytesMoved = {};
+  VkDeviceSize bytesFreed = {};
+  uint32_t allocationsMoved = {};
+  uint32_t blocksFreed = {};
+};
+
+// Moves registered buffers and linear images towards the
+// front of their memory blocks a bounded slice at a time.
+// A slice is recorded into a command buffer by
+// begin_slice(); once that command buffer has finished
+// executing, end_slice() patches the moved handles and
+// their descriptor writes. Registered resources must not be
+// in use by the GPU between the two calls, and nothing may
+// be added or removed while a slice is pending.
+struct defragmenter {
+  explicit defragmenter(
+      VkDevice device,
+      VmaAllocator allocator,
+      VkDeviceSize maxBytesPerSlice,
+      uint32_t maxAllocationsPerSlice)
+      : m_device(device),
+        m_allocator(allocator),
+        m_maxBytesPerSlice(maxBytesPerSlice),
+        m_maxAllocationsPerSlice(maxAllocationsPerSlice) {}
+
+  defragmenter(const defragmenter&) = delete;
+  defragmenter(defragmenter&&) = default;
+  defragmenter& operator=(const defragmenter&) = delete;
+  defragmenter& operator=(defragmenter&&) = default;
+
+  ~defragmenter() noexcept {
+    if (m_context != VK_NULL_HANDLE) {
+      vmaDefragmentationEnd(m_allocator, m_context);
+    }
+  }
+
+  // Mapped buffers must not be registered.
+  void add(buffer& movable) {
+    find_or_add(&movable, nullptr);
+  }
+
+  void add(
+      buffer& movable,
+      descriptor_buffer_write write) {
+    find_or_add(&movable, nullptr)
+        .writes.push_back(write);
+  }
+
+  // Optimal tiling images are ignored, since copying their
+  // memory does not preserve the contents. onMoved is
+  // called after the image handle has been replaced.
+  void add(
+      image& movable,
+      std::function<void(image&)> onMoved = {}) {
+    if (movable.tiling() != VK_IMAGE_TILING_LINEAR) {
+      return;
+    }
+    find_or_add(nullptr, &movable).onMoved =
+        std::move(onMoved);
+  }
+
+  void remove(buffer& movable) {
+    remove_entry(&movable, nullptr);
+  }
+
+  void remove(image& movable) {
+    remove_entry(nullptr, &movable);
+  }
+
+  bool slice_pending() const noexcept {
+    return m_context != VK_NULL_HANDLE;
+  }
+
+  // Records up to one slice of moves into cmd, which must
+  // be in the recording state.
+  tl::expected<void, VkResult> begin_slice(
+      VkCommandBuffer cmd) {
+    if (slice_pending() || m_entries.empty()) {
+      return {};
+    }
+    m_sliceAllocations.clear();
+    for (auto& entry : m_entries) {
+      m_sliceAllocations.push_back(
+          entry.movableBuffer != nullptr
+              ? VmaAllocation(*entry.movableBuffer)
+              : VmaAllocation(*entry.movableImage));
+    }
+    m_sliceChanged.assign(
+        m_sliceAllocations.size(), VK_FALSE);
+
+    VmaDefragmentationInfo2 info = {};
+    info.allocationCount =
+        static_cast<uint32_t>(m_sliceAllocations.size());
+    info.pAllocations = m_sliceAllocations.data();
+    info.pAllocationsChanged = m_sliceChanged.data();
+    info.maxGpuBytesToMove = m_maxBytesPerSlice;
+    info.maxGpuAllocationsToMove = m_maxAllocationsPerSlice;
+    info.commandBuffer = cmd;
+
+    m_sliceStats = {};
+    auto result = vmaDefragmentationBegin(
+        m_allocator, &info, &m_sliceStats, &m_context);
+    if (result != VK_SUCCESS && result != VK_NOT_READY) {
+      m_context = {};
+      return tl::make_unexpected(result);
+    }
+
+    // make the copies visible to whatever uses the moved
+    // resources next
+    VkMemoryBarrier barrier = {
+        VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    barrier.srcAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+    barrier.dstAccessMask = VK_ACCESS_MEMORY_READ_BIT |
+                            VK_ACCESS_MEMORY_WRITE_BIT;
+    vkCmdPipelineBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_TRANSFER_BIT,
+        VK_PIPELINE_STAGE_ALL_COMMANDS_BIT,
+        0,
+        1,
+        &barrier,
+        0,
+        nullptr,
+        0,
+        nullptr);
+    return {};
+  }
+
+  // Call once the command buffer passed to begin_slice()
+  // has finished executing.
+  tl::expected<defragmentation_stats, VkResult>
+  end_slice() {
+    if (!slice_pending()) {
+      return defragmentation_stats{};
+    }
+    auto endResult =
+        vmaDefragmentationEnd(m_allocator, m_context);
+    m_context = {};
+    if (endResult != VK_SUCCESS) {
+      return tl::make_unexpected(endResult);
+    }
+
+    std::vector<VkDescriptorBufferInfo> bufferInfos = {};
+    std::vector<VkWriteDescriptorSet> writes = {};
+    for (size_t i = {}; i < m_entries.size(); ++i) {
+      if (m_sliceChanged[i] != VK_TRUE) {
+        continue;
+      }
+      auto& entry = m_entries[i];
+      if (entry.movableBuffer != nullptr) {
+        auto rebindResult =
+            entry.movableBuffer->rebind(m_device);
+        if (!rebindResult) {
+          return tl::make_unexpected(rebindResult.error());
+        }
+        for (auto& write : entry.writes) {
+          bufferInfos.push_back(
+              {*entry.movableBuffer,
+               write.offset,
+               write.range});
+        }
+      } else {
+        auto rebindResult =
+            entry.movableImage->rebind(m_device);
+        if (!rebindResult) {
+          return tl::make_unexpected(rebindResult.error());
+        }
+        if (entry.onMoved) {
+          entry.onMoved(*entry.movableImage);
+        }
+      }
+    }
+
+    // bufferInfos is complete, so pointers into it are
+    // stable from here on
+    size_t infoIndex = {};
+    for (size_t i = {}; i < m_entries.size(); ++i) {
+      if (m_sliceChanged[i] != VK_TRUE) {
+        continue;
+      }
+      for (auto& write : m_entries[i].writes) {
+        VkWriteDescriptorSet descriptorWrite = {
+            VK_STRUCTURE_TYPE_WRITE_DESCRIPTOR_SET};
+        descriptorWrite.dstSet = write.set;
+        descriptorWrite.dstBinding = write.binding;
+        descriptorWrite.dstArrayElement =
+            write.arrayElement;
+        descriptorWrite.descriptorCount = 1;
+        descriptorWrite.descriptorType = write.type;
+        descriptorWrite.pBufferInfo =
+            &bufferInfos[infoIndex++];
+        writes.push_back(descriptorWrite);
+      }
+    }
+    if (!writes.empty()) {
+      vkUpdateDescriptorSets(
+          m_device,
+          static_cast<uint32_t>(writes.size()),
+          writes.data(),
+          0,
+          nullptr);
+    }
+
+    defragmentation_stats stats = {};
+    stats.bytesMoved = m_sliceStats.bytesMoved;
+    stats.bytesFreed = m_sliceStats.bytesFreed;
+    stats.allocationsMoved = m_sliceStats.allocationsMoved;
+    stats.blocksFreed =
+        m_sliceStats.deviceMemoryBlocksFreed;
+    return stats;
+  }
+
+private:
+  struct movable_entry {
+    buffer* movableBuffer = {};
+    image* movableImage = {};
+    std::vector<descriptor_buffer_write> writes = {};
+    std::function<void(image&)> onMoved = {};
+  };
+
+  movable_entry& find_or_add(
+      buffer* movableBuffer,
+      image* movableImage) {
+    auto it = std::find_if(
+        m_entries.begin(),
+        m_entries.end(),
+        [&](auto& entry) {
+          return entry.movableBuffer == movableBuffer &&
+                 entry.movableImage == movableImage;
+        });
+    if (it != m_entries.end()) {
+      return *it;
+    }
+    movable_entry entry = {};
+    entry.movableBuffer = movableBuffer;
+    entry.movableImage = movableImage;
+    m_entries.push_back(std::move(entry));
+    return m_entries.back();
+  }
+
+  void remove_entry(
+      buffer* movableBuffer,
+      image* movableImage) {
+    m_entries.erase(
+        std::remove_if(
+            m_entries.begin(),
+            m_entries.end(),
+            [&](auto& entry) {
+              return entry.movableBuffer == movableBuffer &&
+                     entry.movableImage == movableImage;
+            }),
+        m_entries.end());
+  }
+
+  VkDevice m_device = {};
+  VmaAllocator m_allocator = {};
+  VkDeviceSize m_maxBytesPerSlice = {};
+  uint32_t m_maxAllocationsPerSlice = {};
+  std::vector<movable_entry> m_entries = {};
+  std::vector<VmaAllocation> m_sliceAllocations = {};
+  std::vector<VkBool32> m_sliceChanged = {};
+  VmaDefragmentationStats m_sliceStats = {};
+  VmaDefragmentationContext m_context = {};
+};
+
+struct defragmenter_builder {
+  tl::expected<std::unique_ptr<defragmenter>, VkResult>
+  build(VkDevice device, VmaAllocator allocator) {
+    return std::make_unique<defragmenter>(
+        device,
+        allocator,
+        m_maxBytesPerSlice,
+        m_maxAllocationsPerSlice);
+  }
+
+  defragmenter_builder& max_bytes_per_slice(
+      VkDeviceSize byteCount) {
+    m_maxBytesPerSlice = byteCount;
+    return *this;
+  }
+
+  defragmenter_builder& max_allocations_per_slice(
+      uint32_t allocationCount) {
+    m_maxAllocationsPerSlice = allocationCount;
+    return *this;
+  }
+
+private:
+  VkDeviceSize m_maxBytesPerSlice = 16 * 1024 * 1024;
+  uint32_t m_maxAllocationsPerSlice = 64;
+};
+}  // namespace vka
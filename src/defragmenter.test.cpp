@@ -0,0 +1,154 @@
+#include "defragmenter.hpp"
+
+#include <catch2/catch.hpp>
+#include <vector>
+#include "command_buffer.hpp"
+#include "command_pool.hpp"
+#include "device.hpp"
+#include "fence.hpp"
+#include "instance.hpp"
+#include "memory_allocator.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue.hpp"
+#include "queue_family.hpp"
+
+using namespace vka;
+TEST_CASE("Defragment buffers in a slice") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::vector<std::unique_ptr<buffer>> buffers = {};
+  for (int i = {}; i < 8; ++i) {
+    buffer_builder{}
+        .size(64 * 1024)
+        .gpu_only()
+        .storage_buffer()
+        .queue_family_index(queueFamily.familyIndex)
+        .build(*allocatorPtr)
+        .map([&](auto bufferPtr) {
+          buffers.push_back(std::move(bufferPtr));
+        })
+        .map_error([](auto error) { REQUIRE(false); });
+  }
+  // leave holes in the block
+  for (size_t i = {}; i < buffers.size(); i += 2) {
+    buffers[i].reset();
+  }
+
+  std::unique_ptr<defragmenter> defragPtr = {};
+  defragmenter_builder{}
+      .max_allocations_per_slice(2)
+      .build(*devicePtr, *allocatorPtr)
+      .map(move_into{defragPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+  for (auto& bufferPtr : buffers) {
+    if (bufferPtr) {
+      defragPtr->add(*bufferPtr);
+    }
+  }
+
+  std::unique_ptr<command_pool> commandPoolPtr = {};
+  command_pool_builder{}
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*devicePtr)
+      .map(move_into{commandPoolPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<command_buffer> commandPtr = {};
+  command_buffer_allocator{}
+      .set_command_pool(commandPoolPtr.get())
+      .allocate(*devicePtr)
+      .map(move_into{commandPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<fence> fencePtr = {};
+  fence_builder{}
+      .build(*devicePtr)
+      .map(move_into{fencePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue graphicsQueue = {};
+  queue_builder{}
+      .queue_info(queueFamily, 0)
+      .build(*devicePtr)
+      .map(move_into{graphicsQueue})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkCommandBuffer cmd = *commandPtr;
+  VkCommandBufferBeginInfo beginInfo = {
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+  beginInfo.flags =
+      VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+  REQUIRE(
+      vkBeginCommandBuffer(cmd, &beginInfo) == VK_SUCCESS);
+  REQUIRE(defragPtr->begin_slice(cmd));
+  REQUIRE(defragPtr->slice_pending());
+  REQUIRE(vkEndCommandBuffer(cmd) == VK_SUCCESS);
+
+  VkSubmitInfo submitInfo = {
+      VK_STRUCTURE_TYPE_SUBMIT_INFO};
+  submitInfo.commandBufferCount = 1;
+  submitInfo.pCommandBuffers = &cmd;
+  VkFence fenceHandle = *fencePtr;
+  REQUIRE(
+      vkQueueSubmit(
+          graphicsQueue, 1, &submitInfo, fenceHandle) ==
+      VK_SUCCESS);
+  REQUIRE(
+      vkWaitForFences(
+          *devicePtr,
+          1,
+          &fenceHandle,
+          VK_TRUE,
+          UINT64_MAX) == VK_SUCCESS);
+
+  defragmentation_stats stats = {};
+  defragPtr->end_slice()
+      .map(move_into{stats})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(!defragPtr->slice_pending());
+  REQUIRE(stats.allocationsMoved <= 2);
+  for (auto& bufferPtr : buffers) {
+    if (bufferPtr) {
+      REQUIRE(
+          bufferPtr->operator VkBuffer() != VK_NULL_HANDLE);
+    }
+  }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <vector>
+#include "fence.hpp"
+#include "gsl-lite.hpp"
+
+namespace vka {
+// Keeps RAII wrappers alive until the fence of the last
+// frame that used them has signaled, then destroys them in
+// one batch per frame.
+struct deletion_queue {
+  explicit deletion_queue(VkDevice device)
+      : m_device(device) {}
+
+  deletion_queue(const deletion_queue&) = delete;
+  deletion_queue(deletion_queue&&) = default;
+  deletion_queue& operator=(const deletion_queue&) = delete;
+  deletion_queue& operator=(deletion_queue&&) = default;
+
+  ~deletion_queue() noexcept { flush(); }
+
+  // lastUseFence is the fence of the most recent submission
+  // that references object, or VK_NULL_HANDLE if it is
+  // never submitted; see fence_unsignaled().
+  template <typename T>
+  void defer(
+      std::unique_ptr<T> object,
+      VkFence lastUseFence) {
+    if (!object) {
+      return;
+    }
+    Expects(
+        lastUseFence == VK_NULL_HANDLE ||
+        fence_unsignaled(m_device, lastUseFence));
+    if (m_pending.empty() ||
+        m_pending.back().fence != lastUseFence) {
+      m_pending.push_back({lastUseFence, {}});
+    }
+    m_pending.back().objects.emplace_back(
+        std::move(object));
+  }
+
+  // Destroys the objects of every frame whose fence has
+  // signaled, oldest first. Call once per frame.
+  void collect() {
+    while (!m_pending.empty()) {
+      auto& oldest = m_pending.front();
+      if (oldest.fence != VK_NULL_HANDLE &&
+          vkGetFenceStatus(m_device, oldest.fence) !=
+              VK_SUCCESS) {
+        break;
+      }
+      m_pending.pop_front();
+    }
+  }
+
+  // Destroys everything without looking at the fences,
+  // which may never signal or be gone by now. The device
+  // must be idle.
+  void flush() noexcept { m_pending.clear(); }
+
+  size_t size() const noexcept {
+    size_t count = {};
+    for (auto& frame : m_pending) {
+      count += frame.objects.size();
+    }
+    return count;
+  }
+
+  bool empty() const noexcept { return m_pending.empty(); }
+
+private:
+  struct retired_frame {
+    VkFence fence = {};
+    std::vector<std::shared_ptr<void>> objects = {};
+  };
+
+  VkDevice m_device = {};
+  std::deque<retired_frame> m_pending = {};
+};
+}  // namespace vka
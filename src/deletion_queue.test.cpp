@@ -0,0 +1,105 @@
+#include "deletion_queue.hpp"
+
+#include <catch2/catch.hpp>
+#include "device.hpp"
+#include "fence.hpp"
+#include "instance.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue.hpp"
+#include "queue_family.hpp"
+
+using namespace vka;
+namespace {
+struct tracked {
+  explicit tracked(int& destroyedCount)
+      : m_destroyedCount(destroyedCount) {}
+  ~tracked() { ++m_destroyedCount; }
+  int& m_destroyedCount;
+};
+}  // namespace
+
+TEST_CASE("Deletion queue batches objects per fence") {
+  int destroyedCount = {};
+  deletion_queue deletions{VK_NULL_HANDLE};
+  deletions.defer(
+      std::make_unique<tracked>(destroyedCount),
+      VK_NULL_HANDLE);
+  deletions.defer(
+      std::make_unique<tracked>(destroyedCount),
+      VK_NULL_HANDLE);
+  REQUIRE(deletions.size() == 2);
+  REQUIRE(destroyedCount == 0);
+  deletions.collect();
+  REQUIRE(deletions.empty());
+  REQUIRE(destroyedCount == 2);
+}
+
+TEST_CASE("Deletion queue waits for the frame fence") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<fence> pendingFence = {};
+  fence_builder{}
+      .build(*devicePtr)
+      .map(move_into{pendingFence})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue graphicsQueue = {};
+  queue_builder{}
+      .queue_info(queueFamily, 0)
+      .build(*devicePtr)
+      .map(move_into{graphicsQueue})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  int destroyedCount = {};
+  deletion_queue deletions{*devicePtr};
+  deletions.defer(
+      std::make_unique<tracked>(destroyedCount),
+      *pendingFence);
+  deletions.collect();
+  REQUIRE(destroyedCount == 0);
+
+  VkFence fenceHandle = *pendingFence;
+  REQUIRE(
+      vkQueueSubmit(
+          graphicsQueue, 0, nullptr, fenceHandle) ==
+      VK_SUCCESS);
+  REQUIRE(
+      vkWaitForFences(
+          *devicePtr,
+          1,
+          &fenceHandle,
+          VK_TRUE,
+          UINT64_MAX) == VK_SUCCESS);
+  deletions.collect();
+  REQUIRE(destroyedCount == 1);
+}
@@ -1,4 +1,6 @@
 #include <vulkan/vulkan.h>
+#include <algorithm>
+#include <cstring>
 #include <memory>
 #include <string_view>
 #include <tl/expected.hpp>
@@ -22,6 +24,58 @@ private:
   VkDevice m_device = {};
 };
 
+#ifdef VK_KHR_synchronization2
+// Whether physicalDevice offers VK_KHR_synchronization2
+// with its feature. The feature query needs an instance
+// with instance_builder::physical_device_properties2().
+inline tl::expected<bool, VkResult>
+synchronization2_supported(
+    VkInstance instance,
+    VkPhysicalDevice physicalDevice) {
+  uint32_t count = {};
+  auto result = vkEnumerateDeviceExtensionProperties(
+      physicalDevice, nullptr, &count, nullptr);
+  if (result != VK_SUCCESS) {
+    return tl::make_unexpected(result);
+  }
+  std::vector<VkExtensionProperties> extensions(count);
+  result = vkEnumerateDeviceExtensionProperties(
+      physicalDevice, nullptr, &count, extensions.data());
+  if (result != VK_SUCCESS) {
+    return tl::make_unexpected(result);
+  }
+  auto found = std::any_of(
+      extensions.begin(),
+      extensions.end(),
+      [](const VkExtensionProperties& extension) {
+        auto name = VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME;
+        return std::strcmp(extension.extensionName, name) ==
+               0;
+      });
+  if (!found) {
+    return false;
+  }
+
+  auto getFeatures2 =
+      reinterpret_cast<PFN_vkGetPhysicalDeviceFeatures2KHR>(
+          vkGetInstanceProcAddr(
+              instance, "vkGetPhysicalDeviceFeatures2KHR"));
+  if (!getFeatures2) {
+    return tl::make_unexpected(
+        VK_ERROR_EXTENSION_NOT_PRESENT);
+  }
+  VkPhysicalDeviceSynchronization2FeaturesKHR
+      synchronization2Features = {
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR};
+  VkPhysicalDeviceFeatures2KHR features = {
+      VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_FEATURES_2_KHR};
+  features.pNext = &synchronization2Features;
+  getFeatures2(physicalDevice, &features);
+  return synchronization2Features.synchronization2 ==
+         VK_TRUE;
+}
+#endif
+
 struct device_builder {
   tl::expected<std::unique_ptr<device>, VkResult> build(
       VkInstance instance) {
@@ -34,6 +88,20 @@ struct device_builder {
     m_createInfo.ppEnabledExtensionNames =
         extensions.data();
     m_createInfo.pEnabledFeatures = &features;
+    void* featureChain = nullptr;
+#ifdef VK_KHR_timeline_semaphore
+    if (m_timelineFeatures.timelineSemaphore) {
+      m_timelineFeatures.pNext = featureChain;
+      featureChain = &m_timelineFeatures;
+    }
+#endif
+#ifdef VK_KHR_synchronization2
+    if (m_synchronization2Features.synchronization2) {
+      m_synchronization2Features.pNext = featureChain;
+      featureChain = &m_synchronization2Features;
+    }
+#endif
+    m_createInfo.pNext = featureChain;
 
     auto result = vkCreateDevice(
         m_physicalDevice, &m_createInfo, nullptr, &device);
@@ -72,6 +140,30 @@ struct device_builder {
     return *this;
   }
 
+#ifdef VK_KHR_timeline_semaphore
+  // Enables VK_KHR_timeline_semaphore and its feature, as
+  // required by timeline_semaphore.
+  device_builder& timeline_semaphore() {
+    extensions.push_back(
+        VK_KHR_TIMELINE_SEMAPHORE_EXTENSION_NAME);
+    m_timelineFeatures.timelineSemaphore = VkBool32(true);
+    return *this;
+  }
+#endif
+
+#ifdef VK_KHR_synchronization2
+  // Enables VK_KHR_synchronization2 and its feature, as
+  // required by synchronization2_functions. Check
+  // synchronization2_supported() first.
+  device_builder& synchronization2() {
+    extensions.push_back(
+        VK_KHR_SYNCHRONIZATION_2_EXTENSION_NAME);
+    m_synchronization2Features.synchronization2 =
+        VkBool32(true);
+    return *this;
+  }
+#endif
+
 private:
   VkPhysicalDevice m_physicalDevice = {};
   std::vector<VkDeviceQueueCreateInfo> queueInfos = {};
@@ -79,5 +171,15 @@ private:
   VkPhysicalDeviceFeatures features = {};
   VkDeviceCreateInfo m_createInfo = {
       VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO};
+#ifdef VK_KHR_timeline_semaphore
+  VkPhysicalDeviceTimelineSemaphoreFeaturesKHR
+      m_timelineFeatures = {
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_TIMELINE_SEMAPHORE_FEATURES_KHR};
+#endif
+#ifdef VK_KHR_synchronization2
+  VkPhysicalDeviceSynchronization2FeaturesKHR
+      m_synchronization2Features = {
+          VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_SYNCHRONIZATION_2_FEATURES_KHR};
+#endif
 };
 }  // namespace vka
\ No newline at end of file
@@ -0,0 +1,193 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <vector>
+#include "command_recorder.hpp"
+
+namespace vka {
+// Sort key layout, most significant first:
+// pass:4 | pipeline:12 | descriptorSet:16 | material:16 |
+// depth:16. Ids are truncated to their field width.
+inline uint64_t make_sort_key(
+    uint32_t pass,
+    uint32_t pipeline,
+    uint32_t descriptorSet,
+    uint32_t material,
+    float depth) noexcept {
+  auto clamped = std::min(std::max(depth, 0.f), 1.f);
+  auto quantized =
+      static_cast<uint64_t>(clamped * float(0xFFFF));
+  return (uint64_t(pass & 0xF) << 60) |
+         (uint64_t(pipeline & 0xFFF) << 48) |
+         (uint64_t(descriptorSet & 0xFFFF) << 32) |
+         (uint64_t(material & 0xFFFF) << 16) | quantized;
+}
+
+inline uint32_t sort_key_pass(uint64_t key) noexcept {
+  return static_cast<uint32_t>(key >> 60);
+}
+
+// One draw. descriptorSet is bound at set 0 and
+// materialSet at set 1; a null indexBuffer records a
+// non-indexed draw of indexCount vertices.
+struct draw_packet {
+  uint64_t key = {};
+  VkPipeline pipeline = {};
+  VkPipelineLayout layout = {};
+  VkDescriptorSet descriptorSet = {};
+  VkDescriptorSet materialSet = {};
+  VkBuffer vertexBuffer = {};
+  VkBuffer indexBuffer = {};
+  VkIndexType indexType = VK_INDEX_TYPE_UINT32;
+  uint32_t indexCount = {};
+  uint32_t instanceCount = 1;
+  uint32_t firstIndex = {};
+  int32_t vertexOffset = {};
+  uint32_t firstInstance = {};
+};
+
+struct sort_entry {
+  uint64_t key = {};
+  uint32_t index = {};
+};
+
+// Least significant digit radix sort on 8 bit digits;
+// passes whose digit is the same for every entry are
+// skipped. Stable, so equal keys keep submission order.
+inline void radix_sort(
+    std::vector<sort_entry>& entries,
+    std::vector<sort_entry>& scratch) {
+  scratch.resize(entries.size());
+  for (uint32_t shift = {}; shift < 64; shift += 8) {
+    std::array<size_t, 256> counts = {};
+    for (auto& entry : entries) {
+      ++counts[(entry.key >> shift) & 0xFF];
+    }
+    auto firstDigit = (entries.front().key >> shift) & 0xFF;
+    if (counts[firstDigit] == entries.size()) {
+      continue;
+    }
+    size_t offset = {};
+    for (auto& count : counts) {
+      auto bucketSize = count;
+      count = offset;
+      offset += bucketSize;
+    }
+    for (auto& entry : entries) {
+      auto digit = (entry.key >> shift) & 0xFF;
+      scratch[counts[digit]++] = entry;
+    }
+    entries.swap(scratch);
+  }
+}
+
+// Per-frame queue of draw packets, sorted by key before
+// recording so that state changes are grouped.
+struct draw_queue {
+  void push(const draw_packet& packet) {
+    auto index = static_cast<uint32_t>(m_packets.size());
+    m_entries.push_back({packet.key, index});
+    m_packets.push_back(packet);
+    m_sorted = false;
+  }
+
+  // Keeps capacity, so steady state frames do not allocate.
+  void clear() noexcept {
+    m_packets.clear();
+    m_entries.clear();
+    m_sorted = true;
+  }
+
+  void sort() {
+    if (!m_sorted && !m_entries.empty()) {
+      radix_sort(m_entries, m_scratch);
+    }
+    m_sorted = true;
+  }
+
+  // Records every packet of one pass, in key order.
+  void record_pass(
+      command_recorder& recorder,
+      uint32_t pass) {
+    sort();
+    auto first = std::lower_bound(
+        m_entries.begin(),
+        m_entries.end(),
+        pass,
+        [](const sort_entry& entry, uint32_t value) {
+          return sort_key_pass(entry.key) < value;
+        });
+    for (auto it = first; it != m_entries.end() &&
+                          sort_key_pass(it->key) == pass;
+         ++it) {
+      record_packet(recorder, m_packets[it->index]);
+    }
+  }
+
+  void record(command_recorder& recorder) {
+    sort();
+    for (auto& entry : m_entries) {
+      record_packet(recorder, m_packets[entry.index]);
+    }
+  }
+
+  // Packet indices in key order.
+  const std::vector<sort_entry>& sorted() {
+    sort();
+    return m_entries;
+  }
+
+  size_t size() const noexcept { return m_packets.size(); }
+
+private:
+  static void record_packet(
+      command_recorder& recorder,
+      const draw_packet& packet) {
+    recorder.bind_pipeline(
+        VK_PIPELINE_BIND_POINT_GRAPHICS, packet.pipeline);
+    if (packet.descriptorSet != VK_NULL_HANDLE) {
+      recorder.bind_descriptor_sets(
+          VK_PIPELINE_BIND_POINT_GRAPHICS,
+          packet.layout,
+          0,
+          {&packet.descriptorSet, 1});
+    }
+    if (packet.materialSet != VK_NULL_HANDLE) {
+      recorder.bind_descriptor_sets(
+          VK_PIPELINE_BIND_POINT_GRAPHICS,
+          packet.layout,
+          1,
+          {&packet.materialSet, 1});
+    }
+    if (packet.vertexBuffer != VK_NULL_HANDLE) {
+      VkDeviceSize offset = {};
+      recorder.bind_vertex_buffers(
+          0, {&packet.vertexBuffer, 1}, {&offset, 1});
+    }
+    if (packet.indexBuffer != VK_NULL_HANDLE) {
+      recorder.bind_index_buffer(
+          packet.indexBuffer, 0, packet.indexType);
+      recorder.draw_indexed(
+          packet.indexCount,
+          packet.instanceCount,
+          packet.firstIndex,
+          packet.vertexOffset,
+          packet.firstInstance);
+    } else {
+      recorder.draw(
+          packet.indexCount,
+          packet.instanceCount,
+          static_cast<uint32_t>(packet.vertexOffset),
+          packet.firstInstance);
+    }
+  }
+
+  std::vector<draw_packet> m_packets = {};
+  std::vector<sort_entry> m_entries = {};
+  std::vector<sort_entry> m_scratch = {};
+  bool m_sorted = true;
+};
+}  // namespace vka
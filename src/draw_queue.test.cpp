@@ -0,0 +1,60 @@
+#include "draw_queue.hpp"
+
+#include <algorithm>
+#include <catch2/catch.hpp>
+#include <random>
+#include <vector>
+
+using namespace vka;
+TEST_CASE("Sort key orders pass before state") {
+  auto early = make_sort_key(0, 9, 9, 9, 1.f);
+  auto late = make_sort_key(1, 0, 0, 0, 0.f);
+  REQUIRE(early < late);
+  REQUIRE(sort_key_pass(late) == 1);
+  REQUIRE(
+      make_sort_key(0, 1, 0, 0, 0.f) >
+      make_sort_key(0, 0, 9, 9, 1.f));
+  REQUIRE(
+      make_sort_key(0, 0, 0, 0, 0.25f) <
+      make_sort_key(0, 0, 0, 0, 0.75f));
+}
+
+TEST_CASE("Radix sort matches a stable sort") {
+  std::mt19937_64 random{1234};
+  std::vector<sort_entry> entries = {};
+  for (uint32_t i = {}; i < 1000; ++i) {
+    entries.push_back({random() % 64 << 40, i});
+  }
+  auto expected = entries;
+  std::stable_sort(
+      expected.begin(),
+      expected.end(),
+      [](auto& a, auto& b) { return a.key < b.key; });
+
+  std::vector<sort_entry> scratch = {};
+  radix_sort(entries, scratch);
+  for (size_t i = {}; i < entries.size(); ++i) {
+    REQUIRE(entries[i].key == expected[i].key);
+    REQUIRE(entries[i].index == expected[i].index);
+  }
+}
+
+TEST_CASE("Draw queue sorts packets by key") {
+  draw_queue queue = {};
+  draw_packet packet = {};
+  packet.key = make_sort_key(1, 0, 0, 0, 0.f);
+  queue.push(packet);
+  packet.key = make_sort_key(0, 2, 0, 0, 0.f);
+  queue.push(packet);
+  packet.key = make_sort_key(0, 1, 0, 0, 0.f);
+  queue.push(packet);
+
+  auto& sorted = queue.sorted();
+  REQUIRE(sorted.size() == 3);
+  REQUIRE(sorted[0].index == 2);
+  REQUIRE(sorted[1].index == 1);
+  REQUIRE(sorted[2].index == 0);
+
+  queue.clear();
+  REQUIRE(queue.size() == 0);
+}
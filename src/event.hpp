@@ -0,0 +1,143 @@
+#pragma once
+#include <vulkan/vulkan.h>
+#include <deque>
+#include <memory>
+#include <tl/expected.hpp>
+#include <vector>
+#include "fence.hpp"
+#include "gsl-lite.hpp"
+
+namespace vka {
+struct event {
+  explicit event(VkDevice device, VkEvent eventHandle)
+      : m_device(device), m_event(eventHandle) {}
+
+  event(const event&) = delete;
+  event(event&&) = default;
+  event& operator=(const event&) = delete;
+  event& operator=(event&&) = default;
+
+  ~event() noexcept {
+    vkDestroyEvent(m_device, m_event, nullptr);
+  }
+
+  operator VkEvent() const noexcept { return m_event; }
+
+  // VK_EVENT_SET or VK_EVENT_RESET.
+  VkResult status() const noexcept {
+    return vkGetEventStatus(m_device, m_event);
+  }
+
+  tl::expected<void, VkResult> reset() noexcept {
+    auto result = vkResetEvent(m_device, m_event);
+    if (result != VK_SUCCESS) {
+      return tl::make_unexpected(result);
+    }
+    return {};
+  }
+
+private:
+  VkDevice m_device = {};
+  VkEvent m_event = {};
+};
+
+struct event_builder {
+  tl::expected<std::unique_ptr<event>, VkResult> build(
+      VkDevice device) {
+    VkEventCreateInfo createInfo = {
+        VK_STRUCTURE_TYPE_EVENT_CREATE_INFO};
+
+    VkEvent eventHandle = {};
+    auto result = vkCreateEvent(
+        device, &createInfo, nullptr, &eventHandle);
+    if (result != VK_SUCCESS) {
+      return tl::make_unexpected(result);
+    }
+
+    return std::make_unique<event>(device, eventHandle);
+  }
+};
+
+// Recycles events instead of destroying them. An event set
+// or waited on by a command buffer may only be reused once
+// that command buffer has completed, so release() takes the
+// fence of its submission; the event is reset from the host
+// once the fence has signaled. Not thread safe.
+struct event_pool {
+  explicit event_pool(VkDevice device) : m_device(device) {}
+
+  event_pool(const event_pool&) = delete;
+  event_pool(event_pool&&) = default;
+  event_pool& operator=(const event_pool&) = delete;
+  event_pool& operator=(event_pool&&) = default;
+
+  // The returned event is reset.
+  tl::expected<std::unique_ptr<event>, VkResult> acquire() {
+    auto collectResult = collect();
+    if (!collectResult) {
+      return tl::make_unexpected(collectResult.error());
+    }
+    if (m_free.empty()) {
+      auto eventResult = event_builder{}.build(m_device);
+      if (eventResult) {
+        ++m_createdCount;
+      }
+      return eventResult;
+    }
+    auto eventPtr = std::move(m_free.back());
+    m_free.pop_back();
+    return eventPtr;
+  }
+
+  // useFence is signaled by the submission that uses the
+  // event; see fence_unsignaled(). A null fence means the
+  // event has no pending use.
+  void release(
+      std::unique_ptr<event> eventPtr,
+      VkFence useFence = VK_NULL_HANDLE) {
+    Expects(
+        useFence == VK_NULL_HANDLE ||
+        fence_unsignaled(m_device, useFence));
+    m_parked.push_back({std::move(eventPtr), useFence});
+  }
+
+  // Resets the events whose fences have signaled and moves
+  // them to the free list, oldest first.
+  tl::expected<void, VkResult> collect() {
+    while (!m_parked.empty()) {
+      auto& oldest = m_parked.front();
+      if (oldest.useFence != VK_NULL_HANDLE &&
+          vkGetFenceStatus(m_device, oldest.useFence) !=
+              VK_SUCCESS) {
+        break;
+      }
+      auto resetResult = oldest.eventPtr->reset();
+      if (!resetResult) {
+        return resetResult;
+      }
+      m_free.push_back(std::move(oldest.eventPtr));
+      m_parked.pop_front();
+    }
+    return {};
+  }
+
+  size_t available() const noexcept {
+    return m_free.size();
+  }
+
+  size_t created_count() const noexcept {
+    return m_createdCount;
+  }
+
+private:
+  struct parked_event {
+    std::unique_ptr<event> eventPtr = {};
+    VkFence useFence = {};
+  };
+
+  VkDevice m_device = {};
+  std::vector<std::unique_ptr<event>> m_free = {};
+  std::deque<parked_event> m_parked = {};
+  size_t m_createdCount = {};
+};
+}  // namespace vka
@@ -0,0 +1,132 @@
+#include "event.hpp"
+
+#include <catch2/catch.hpp>
+#include "device.hpp"
+#include "fence.hpp"
+#include "instance.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue.hpp"
+#include "queue_family.hpp"
+
+using namespace vka;
+TEST_CASE("Create an event") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<event> eventPtr = {};
+  event_builder{}
+      .build(*devicePtr)
+      .map(move_into{eventPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(eventPtr->operator VkEvent() != VK_NULL_HANDLE);
+  REQUIRE(eventPtr->status() == VK_EVENT_RESET);
+}
+
+TEST_CASE("Event pool resets events after their fence") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<fence> useFence = {};
+  fence_builder{}
+      .build(*devicePtr)
+      .map(move_into{useFence})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue graphicsQueue = {};
+  queue_builder{}
+      .queue_info(queueFamily, 0)
+      .build(*devicePtr)
+      .map(move_into{graphicsQueue})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  event_pool pool{*devicePtr};
+  std::unique_ptr<event> eventPtr = {};
+  pool.acquire()
+      .map(move_into{eventPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(pool.created_count() == 1);
+  VkEvent eventHandle = *eventPtr;
+  REQUIRE(
+      vkSetEvent(*devicePtr, eventHandle) == VK_SUCCESS);
+
+  pool.release(std::move(eventPtr), *useFence);
+  REQUIRE(pool.collect());
+  REQUIRE(pool.available() == 0);
+
+  VkFence fenceHandle = *useFence;
+  REQUIRE(
+      vkQueueSubmit(
+          graphicsQueue, 0, nullptr, fenceHandle) ==
+      VK_SUCCESS);
+  REQUIRE(
+      vkWaitForFences(
+          *devicePtr,
+          1,
+          &fenceHandle,
+          VK_TRUE,
+          UINT64_MAX) == VK_SUCCESS);
+  REQUIRE(pool.collect());
+  REQUIRE(pool.available() == 1);
+
+  pool.acquire()
+      .map(move_into{eventPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(pool.created_count() == 1);
+  REQUIRE(eventPtr->status() == VK_EVENT_RESET);
+}
@@ -3,6 +3,7 @@
 #include <vulkan/vulkan.h>
 #include <memory>
 #include <tl/expected.hpp>
+#include <vector>
 
 namespace vka {
 struct fence {
@@ -52,4 +53,76 @@ struct fence_builder {
 private:
   bool m_createSignaled = {};
 };
+
+// Pools that recycle an object once a fence signals take
+// the fence while it is unsignaled: reset, and not yet
+// submitted, after which it may signal at any time. A fence
+// still signaled from its previous use would recycle the
+// object while the GPU may use it.
+inline bool fence_unsignaled(
+    VkDevice device,
+    VkFence fence) {
+  return vkGetFenceStatus(device, fence) == VK_NOT_READY;
+}
+
+// Recycles fences instead of destroying them. Released
+// fences are reset together with a single vkResetFences
+// once the free list runs dry, so steady state frames
+// create no fences. Not thread safe.
+struct fence_pool {
+  explicit fence_pool(VkDevice device) : m_device(device) {}
+
+  fence_pool(const fence_pool&) = delete;
+  fence_pool(fence_pool&&) = default;
+  fence_pool& operator=(const fence_pool&) = delete;
+  fence_pool& operator=(fence_pool&&) = default;
+
+  // The returned fence is unsignaled.
+  tl::expected<std::unique_ptr<fence>, VkResult> acquire() {
+    if (m_free.empty() && !m_released.empty()) {
+      m_resetHandles.clear();
+      for (auto& released : m_released) {
+        m_resetHandles.push_back(*released);
+      }
+      auto result = vkResetFences(
+          m_device,
+          static_cast<uint32_t>(m_resetHandles.size()),
+          m_resetHandles.data());
+      if (result != VK_SUCCESS) {
+        return tl::make_unexpected(result);
+      }
+      m_free.swap(m_released);
+    }
+    if (m_free.empty()) {
+      auto fenceResult = fence_builder{}.build(m_device);
+      if (fenceResult) {
+        ++m_createdCount;
+      }
+      return fenceResult;
+    }
+    auto fencePtr = std::move(m_free.back());
+    m_free.pop_back();
+    return fencePtr;
+  }
+
+  // The fence must have no pending queue operation.
+  void release(std::unique_ptr<fence> fencePtr) {
+    m_released.push_back(std::move(fencePtr));
+  }
+
+  size_t available() const noexcept {
+    return m_free.size() + m_released.size();
+  }
+
+  size_t created_count() const noexcept {
+    return m_createdCount;
+  }
+
+private:
+  VkDevice m_device = {};
+  std::vector<std::unique_ptr<fence>> m_free = {};
+  std::vector<std::unique_ptr<fence>> m_released = {};
+  std::vector<VkFence> m_resetHandles = {};
+  size_t m_createdCount = {};
+};
 }  // namespace vka
\ No newline at end of file
@@ -47,4 +47,61 @@ TEST_CASE("Create a signaled fence") {
       .map(move_into{fencePtr})
       .map_error([](auto error) { REQUIRE(false); });
   REQUIRE(fencePtr->operator VkFence() != VK_NULL_HANDLE);
+}
+
+TEST_CASE("Fence pool recycles released fences") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  fence_pool pool{*devicePtr};
+  std::unique_ptr<fence> first = {};
+  pool.acquire()
+      .map(move_into{first})
+      .map_error([](auto error) { REQUIRE(false); });
+  std::unique_ptr<fence> second = {};
+  pool.acquire()
+      .map(move_into{second})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(pool.created_count() == 2);
+
+  pool.release(std::move(first));
+  pool.release(std::move(second));
+  REQUIRE(pool.available() == 2);
+
+  std::unique_ptr<fence> reused = {};
+  pool.acquire()
+      .map(move_into{reused})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(pool.created_count() == 2);
+  REQUIRE(pool.available() == 1);
+  REQUIRE(
+      vkGetFenceStatus(*devicePtr, *reused) ==
+      VK_NOT_READY);
 }
\ No newline at end of file
@@ -0,0 +1,191 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include "fence.hpp"
+
+namespace vka {
+// Stored in a future whose fence could not be waited on,
+// e.g. with VK_ERROR_DEVICE_LOST.
+struct fence_wait_error {
+  VkResult result = {};
+};
+
+// Waits on watched fences from a background thread, in
+// batches with vkWaitForFences(waitAll = false), and
+// completes a future for each once its fence signals. The
+// futures can be shared and handed to States<T, N>.
+struct fence_waiter {
+  explicit fence_waiter(
+      VkDevice device,
+      std::chrono::nanoseconds pollInterval =
+          std::chrono::milliseconds(1))
+      : m_device(device),
+        m_pollInterval(pollInterval),
+        m_thread([this] { run(); }) {}
+
+  fence_waiter(const fence_waiter&) = delete;
+  fence_waiter(fence_waiter&&) = delete;
+  fence_waiter& operator=(const fence_waiter&) = delete;
+  fence_waiter& operator=(fence_waiter&&) = delete;
+
+  // Waits for every watched fence before joining, so a
+  // watched fence that is never submitted blocks it
+  // forever.
+  ~fence_waiter() noexcept {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_thread.join();
+  }
+
+  // Runs onSignaled on the waiter thread once fence has
+  // signaled and completes the returned future with its
+  // result. onSignaled may be move-only. fence must outlive
+  // the wait and be submitted before the waiter is
+  // destroyed.
+  template <typename F>
+  auto when_signaled(VkFence fence, F onSignaled)
+      -> std::future<std::invoke_result_t<F>> {
+    return watch(fence, {}, std::move(onSignaled));
+  }
+
+  // As above, but the waiter owns the fence and destroys
+  // it after onSignaled has run.
+  template <typename F>
+  auto when_signaled(
+      std::unique_ptr<fence> fencePtr,
+      F onSignaled)
+      -> std::future<std::invoke_result_t<F>> {
+    VkFence fenceHandle = *fencePtr;
+    return watch(
+        fenceHandle,
+        std::shared_ptr<fence>(std::move(fencePtr)),
+        std::move(onSignaled));
+  }
+
+  std::future<void> when_signaled(VkFence fence) {
+    return when_signaled(fence, [] {});
+  }
+
+private:
+  struct watched_fence {
+    VkFence handle = {};
+    std::shared_ptr<fence> owned = {};
+    std::function<void(VkResult)> complete = {};
+  };
+
+  template <typename F>
+  auto watch(
+      VkFence fenceHandle,
+      std::shared_ptr<fence> owned,
+      F onSignaled)
+      -> std::future<std::invoke_result_t<F>> {
+    using result_type = std::invoke_result_t<F>;
+    auto promise =
+        std::make_shared<std::promise<result_type>>();
+    auto future = promise->get_future();
+    // shared so that complete stays copyable for
+    // std::function even when onSignaled is move-only
+    auto callback =
+        std::make_shared<F>(std::move(onSignaled));
+    auto complete = [promise, callback](VkResult result) {
+      if (result != VK_SUCCESS) {
+        promise->set_exception(std::make_exception_ptr(
+            fence_wait_error{result}));
+        return;
+      }
+      try {
+        if constexpr (std::is_void_v<result_type>) {
+          (*callback)();
+          promise->set_value();
+        } else {
+          promise->set_value((*callback)());
+        }
+      } catch (...) {
+        promise->set_exception(std::current_exception());
+      }
+    };
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_incoming.push_back(
+          {fenceHandle, std::move(owned), complete});
+    }
+    m_wake.notify_one();
+    return future;
+  }
+
+  void run() {
+    std::vector<watched_fence> watched = {};
+    std::vector<VkFence> handles = {};
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [&] {
+          return m_stopping || !m_incoming.empty() ||
+                 !watched.empty();
+        });
+        for (auto& incoming : m_incoming) {
+          watched.push_back(std::move(incoming));
+        }
+        m_incoming.clear();
+        if (watched.empty()) {
+          return;
+        }
+      }
+
+      handles.clear();
+      for (auto& entry : watched) {
+        handles.push_back(entry.handle);
+      }
+      auto waitResult = vkWaitForFences(
+          m_device,
+          static_cast<uint32_t>(handles.size()),
+          handles.data(),
+          VK_FALSE,
+          static_cast<uint64_t>(m_pollInterval.count()));
+      if (waitResult == VK_TIMEOUT) {
+        continue;
+      }
+      if (waitResult != VK_SUCCESS) {
+        for (auto& entry : watched) {
+          entry.complete(waitResult);
+        }
+        watched.clear();
+        continue;
+      }
+
+      auto signaled = std::stable_partition(
+          watched.begin(), watched.end(), [&](auto& entry) {
+            auto status =
+                vkGetFenceStatus(m_device, entry.handle);
+            return status != VK_SUCCESS;
+          });
+      for (auto it = signaled; it != watched.end(); ++it) {
+        it->complete(VK_SUCCESS);
+      }
+      watched.erase(signaled, watched.end());
+    }
+  }
+
+  VkDevice m_device = {};
+  std::chrono::nanoseconds m_pollInterval = {};
+  std::mutex m_mutex = {};
+  std::condition_variable m_wake = {};
+  std::vector<watched_fence> m_incoming = {};
+  bool m_stopping = {};
+  std::thread m_thread;
+};
+}  // namespace vka
@@ -0,0 +1,87 @@
+#include "fence_waiter.hpp"
+
+#include <catch2/catch.hpp>
+#include "device.hpp"
+#include "instance.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue.hpp"
+#include "queue_family.hpp"
+#include "states.hpp"
+
+using namespace vka;
+TEST_CASE("Fence waiter completes futures for States") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue graphicsQueue = {};
+  queue_builder{}
+      .queue_info(queueFamily, 0)
+      .build(*devicePtr)
+      .map(move_into{graphicsQueue})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<fence> readbackFence = {};
+  fence_builder{}
+      .build(*devicePtr)
+      .map(move_into{readbackFence})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<fence> ownedFence = {};
+  fence_builder{}
+      .build(*devicePtr)
+      .map(move_into{ownedFence})
+      .map_error([](auto error) { REQUIRE(false); });
+  VkFence ownedHandle = *ownedFence;
+
+  fence_waiter waiter{*devicePtr};
+  States<int, 2> states;
+  auto readback = [] { return 42; };
+  auto readbackDone =
+      waiter.when_signaled(*readbackFence, readback);
+  states.add(readbackDone.share());
+  // a move-only callback
+  auto token = std::make_unique<int>(7);
+  auto ownedDone = waiter.when_signaled(
+      std::move(ownedFence),
+      [token = std::move(token)] { return *token; });
+
+  graphicsQueue.submit({}, *readbackFence)
+      .map_error([](auto error) { REQUIRE(false); });
+  graphicsQueue.submit({}, ownedHandle)
+      .map_error([](auto error) { REQUIRE(false); });
+
+  auto latest = states.latest();
+  REQUIRE(latest);
+  REQUIRE_NOTHROW(latest->sync());
+  REQUIRE(latest->value() == 42);
+  REQUIRE(ownedDone.get() == 7);
+}
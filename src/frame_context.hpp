@@ -0,0 +1,195 @@
+#pragma once
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+#include <tl/expected.hpp>
+#include <tl/optional.hpp>
+#include <vector>
+#include "command_pool_manager.hpp"
+#include "fence.hpp"
+#include "ring_allocator.hpp"
+#include "semaphore.hpp"
+
+namespace vka {
+// Synchronization objects for one frame in flight. The
+// frame's last submission must signal frameFence.
+struct frame_context {
+  uint32_t index = {};
+  std::unique_ptr<fence> frameFence = {};
+  std::unique_ptr<semaphore> imageAvailable = {};
+  std::unique_ptr<semaphore> renderFinished = {};
+};
+
+// A ring of frame contexts. begin_frame() only waits for
+// the oldest frame in flight, the one whose context is
+// being reused, so the CPU can record up to frame_count()
+// frames ahead of the GPU.
+struct frame_ring {
+  explicit frame_ring(
+      VkDevice device,
+      std::vector<frame_context> frames,
+      std::unique_ptr<command_pool_manager> commandPools,
+      std::unique_ptr<ring_allocator> transient)
+      : m_device(device),
+        m_frames(std::move(frames)),
+        m_commandPools(std::move(commandPools)),
+        m_transient(std::move(transient)) {}
+
+  frame_ring(const frame_ring&) = delete;
+  frame_ring(frame_ring&&) = default;
+  frame_ring& operator=(const frame_ring&) = delete;
+  frame_ring& operator=(frame_ring&&) = default;
+
+  // Waits for the frame that last used the next context,
+  // then recycles its fence, command pools and transient
+  // allocations. Fails with VK_TIMEOUT if the fence does
+  // not signal within timeout nanoseconds.
+  tl::expected<frame_context*, VkResult> begin_frame(
+      uint64_t timeout = UINT64_MAX) {
+    auto& frame = m_frames[m_current];
+    VkFence frameFence = *frame.frameFence;
+    auto waitResult = vkWaitForFences(
+        m_device, 1, &frameFence, VK_TRUE, timeout);
+    if (waitResult != VK_SUCCESS) {
+      return tl::make_unexpected(waitResult);
+    }
+    // reclaim polls the fences, so it must see this one
+    // signaled before the reset
+    if (m_transient) {
+      m_transient->reclaim();
+    }
+    auto resetResult =
+        vkResetFences(m_device, 1, &frameFence);
+    if (resetResult != VK_SUCCESS) {
+      return tl::make_unexpected(resetResult);
+    }
+
+    auto poolResult =
+        m_commandPools->begin_frame(frame.index);
+    if (!poolResult) {
+      return tl::make_unexpected(poolResult.error());
+    }
+    return &frame;
+  }
+
+  // Closes the current frame and advances to the next
+  // context. The frame's submissions must have been made,
+  // with the last one signaling its frameFence.
+  void end_frame() {
+    auto& frame = m_frames[m_current];
+    if (m_transient) {
+      m_transient->end_frame(*frame.frameFence);
+    }
+    m_current = (m_current + 1) % frame_count();
+  }
+
+  command_pool_manager& command_pools() noexcept {
+    return *m_commandPools;
+  }
+
+  // Only present when the builder was given a
+  // transient_allocator.
+  ring_allocator* transient() noexcept {
+    return m_transient.get();
+  }
+
+  uint32_t frame_count() const noexcept {
+    return static_cast<uint32_t>(m_frames.size());
+  }
+
+private:
+  VkDevice m_device = {};
+  std::vector<frame_context> m_frames = {};
+  std::unique_ptr<command_pool_manager> m_commandPools = {};
+  std::unique_ptr<ring_allocator> m_transient = {};
+  uint32_t m_current = {};
+};
+
+struct frame_ring_builder {
+  tl::expected<std::unique_ptr<frame_ring>, VkResult> build(
+      VkDevice device,
+      VmaAllocator allocator) {
+    std::vector<frame_context> frames(m_frameCount);
+    for (uint32_t i = {}; i < m_frameCount; ++i) {
+      auto& frame = frames[i];
+      frame.index = i;
+      auto fenceResult =
+          fence_builder{}.signaled().build(device);
+      if (!fenceResult) {
+        return tl::make_unexpected(fenceResult.error());
+      }
+      frame.frameFence = std::move(*fenceResult);
+
+      auto availableResult =
+          semaphore_builder{}.build(device);
+      if (!availableResult) {
+        return tl::make_unexpected(availableResult.error());
+      }
+      frame.imageAvailable = std::move(*availableResult);
+
+      auto finishedResult =
+          semaphore_builder{}.build(device);
+      if (!finishedResult) {
+        return tl::make_unexpected(finishedResult.error());
+      }
+      frame.renderFinished = std::move(*finishedResult);
+    }
+
+    auto poolsResult = m_commandPoolBuilder
+                           .frames_in_flight(m_frameCount)
+                           .build(device);
+    if (!poolsResult) {
+      return tl::make_unexpected(poolsResult.error());
+    }
+
+    std::unique_ptr<ring_allocator> transient = {};
+    if (m_transientBuilder) {
+      auto transientResult =
+          m_transientBuilder->build(device, allocator);
+      if (!transientResult) {
+        return tl::make_unexpected(transientResult.error());
+      }
+      transient = std::move(*transientResult);
+    }
+
+    return std::make_unique<frame_ring>(
+        device,
+        std::move(frames),
+        std::move(*poolsResult),
+        std::move(transient));
+  }
+
+  frame_ring_builder& frames_in_flight(uint32_t count) {
+    m_frameCount = count;
+    return *this;
+  }
+
+  frame_ring_builder& queue_family_index(uint32_t index) {
+    m_commandPoolBuilder.queue_family_index(index);
+    return *this;
+  }
+
+  // Number of recording threads, each with its own command
+  // pool per frame.
+  frame_ring_builder& thread_count(uint32_t count) {
+    m_commandPoolBuilder.thread_count(count);
+    return *this;
+  }
+
+  // Per-frame transient memory, reclaimed when the frame
+  // that allocated it has finished.
+  frame_ring_builder& transient_allocator(
+      ring_allocator_builder transientBuilder) {
+    m_transientBuilder = transientBuilder;
+    return *this;
+  }
+
+private:
+  uint32_t m_frameCount = 2;
+  command_pool_manager_builder m_commandPoolBuilder = {};
+  tl::optional<ring_allocator_builder> m_transientBuilder =
+      {};
+};
+}  // namespace vka
@@ -0,0 +1,90 @@
+#include "frame_context.hpp"
+
+#include <catch2/catch.hpp>
+#include "device.hpp"
+#include "instance.hpp"
+#include "memory_allocator.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue.hpp"
+#include "queue_family.hpp"
+
+using namespace vka;
+TEST_CASE("Frame ring cycles through its contexts") {
+TEST_CASE("Allocate from a ring allocator") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+
+  queue graphicsQueue = {};
+  queue_builder{}
+      .queue_info(queueFamily, 0)
+      .build(*devicePtr)
+      .map(move_into{graphicsQueue})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<frame_ring> framesPtr = {};
+  frame_ring_builder{}
+      .frames_in_flight(2)
+      .queue_family_index(queueFamily.familyIndex)
+      .transient_allocator(
+          ring_allocator_builder{}
+              .size(4096)
+              .uniform_buffer())
+      .build(*devicePtr, *allocatorPtr)
+      .map(move_into{framesPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(framesPtr->frame_count() == 2);
+  REQUIRE(framesPtr->transient() != nullptr);
+
+  for (uint32_t i = {}; i < 5; ++i) {
+    frame_context* frame = {};
+    framesPtr->begin_frame()
+        .map(move_into{frame})
+        .map_error([](auto error) { REQUIRE(false); });
+    REQUIRE(frame->index == i % 2);
+
+    REQUIRE(framesPtr->transient()->allocate(256));
+    auto cmdResult = framesPtr->command_pools().acquire(0);
+    REQUIRE(cmdResult);
+
+    graphicsQueue.submit({}, *frame->frameFence)
+        .map_error([](auto error) { REQUIRE(false); });
+    framesPtr->end_frame();
+  }
+  REQUIRE(vkDeviceWaitIdle(*devicePtr) == VK_SUCCESS);
+}
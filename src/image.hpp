@@ -2,6 +2,7 @@
 
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan.h>
+#include <algorithm>
 #include <memory>
 #include <tl/expected.hpp>
 
@@ -19,14 +20,21 @@ struct image {
       VkImageType imageType,
       VkFormat imageFormat,
       uint32_t arrayLayers,
-      image_aspect aspect)
+      image_aspect aspect,
+      VkImageCreateInfo createInfo = {},
+      bool lazilyAllocated = {})
       : m_allocator(allocator),
         m_allocation(allocation),
         m_image(imageHandle),
         m_imageType(imageType),
         m_imageFormat(imageFormat),
         m_arrayLayers(arrayLayers),
-        m_aspect(aspect) {}
+        m_aspect(aspect),
+        m_createInfo(createInfo),
+        m_lazilyAllocated(lazilyAllocated) {
+    m_createInfo.queueFamilyIndexCount = 0;
+    m_createInfo.pQueueFamilyIndices = {};
+  }
 
   image(const image&) = delete;
   image(image&&) = default;
@@ -54,10 +62,76 @@ struct image {
     return m_arrayLayers;
   }
 
+  VkExtent3D extent() const noexcept {
+    return m_createInfo.extent;
+  }
+
+  VkSampleCountFlagBits samples() const noexcept {
+    return m_createInfo.samples;
+  }
+
+  uint32_t mip_levels() const noexcept {
+    return std::max(m_createInfo.mipLevels, 1u);
+  }
+
   image_aspect get_image_aspect() const noexcept {
     return m_aspect;
   }
 
+  VkImageTiling tiling() const noexcept {
+    return m_createInfo.tiling;
+  }
+
+  bool lazily_allocated() const noexcept {
+    return m_lazilyAllocated;
+  }
+
+  // Bytes of the allocation that the driver has not had to
+  // back with physical memory; 0 unless lazily allocated.
+  VkDeviceSize bytes_avoided(
+      VkDevice device) const noexcept {
+    if (!m_lazilyAllocated) {
+      return 0;
+    }
+    VmaAllocationInfo allocationInfo = {};
+    vmaGetAllocationInfo(
+        m_allocator, m_allocation, &allocationInfo);
+    VkDeviceSize committed = {};
+    vkGetDeviceMemoryCommitment(
+        device, allocationInfo.deviceMemory, &committed);
+    return committed < allocationInfo.size
+               ? allocationInfo.size - committed
+               : 0;
+  }
+
+  // Replaces the image handle with a new one bound to the
+  // allocation's current memory, after defragmentation
+  // has moved it. The new image starts in
+  // VK_IMAGE_LAYOUT_PREINITIALIZED and any views of the old
+  // image must be recreated.
+  tl::expected<void, VkResult> rebind(
+      VkDevice device) noexcept {
+    auto imageCreateInfo = m_createInfo;
+    imageCreateInfo.initialLayout =
+        VK_IMAGE_LAYOUT_PREINITIALIZED;
+
+    VkImage imageHandle = {};
+    auto createResult = vkCreateImage(
+        device, &imageCreateInfo, nullptr, &imageHandle);
+    if (createResult != VK_SUCCESS) {
+      return tl::make_unexpected(createResult);
+    }
+    auto bindResult = vmaBindImageMemory(
+        m_allocator, m_allocation, imageHandle);
+    if (bindResult != VK_SUCCESS) {
+      vkDestroyImage(device, imageHandle, nullptr);
+      return tl::make_unexpected(bindResult);
+    }
+    vkDestroyImage(device, m_image, nullptr);
+    m_image = imageHandle;
+    return {};
+  }
+
 private:
   VmaAllocator m_allocator = {};
   VmaAllocation m_allocation = {};
@@ -66,6 +140,8 @@ private:
   VkFormat m_imageFormat = {};
   uint32_t m_arrayLayers = {};
   image_aspect m_aspect = {};
+  VkImageCreateInfo m_createInfo = {};
+  bool m_lazilyAllocated = {};
 };
 
 struct image_builder {
@@ -76,24 +152,33 @@ struct image_builder {
     allocationCreateInfo.usage = m_memoryUsage;
     allocationCreateInfo.pool = m_memoryPool;
 
-    VkImageCreateInfo imageCreateInfo = {
-        VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
-    imageCreateInfo.format = m_format;
-    imageCreateInfo.imageType = m_imageType;
-    imageCreateInfo.tiling = m_tiling;
-    imageCreateInfo.samples = m_samples;
-    imageCreateInfo.mipLevels = m_mipLevels;
-    imageCreateInfo.usage = m_imageUsage;
-    imageCreateInfo.initialLayout =
-        ((m_tiling == VK_IMAGE_TILING_OPTIMAL)
-             ? VK_IMAGE_LAYOUT_UNDEFINED
-             : VK_IMAGE_LAYOUT_PREINITIALIZED);
-    imageCreateInfo.queueFamilyIndexCount = 1;
-    imageCreateInfo.pQueueFamilyIndices =
-        &m_queueFamilyIndex;
-    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
-    imageCreateInfo.arrayLayers = m_arrayLayers;
-    imageCreateInfo.extent = m_imageExtent;
+    auto imageCreateInfo = create_info();
+
+    // Transient attachments prefer lazily allocated memory,
+    // falling back to the requested usage when the device
+    // has none. A dedicated allocation keeps the driver's
+    // commitment per image.
+    auto lazilyAllocated = false;
+    if ((m_imageUsage &
+         VK_IMAGE_USAGE_TRANSIENT_ATTACHMENT_BIT) != 0 &&
+        m_memoryPool == VK_NULL_HANDLE) {
+      auto lazyCreateInfo = allocationCreateInfo;
+      lazyCreateInfo.requiredFlags |=
+          VK_MEMORY_PROPERTY_LAZILY_ALLOCATED_BIT;
+      uint32_t lazyTypeIndex = {};
+      auto findResult = vmaFindMemoryTypeIndexForImageInfo(
+          allocator,
+          &imageCreateInfo,
+          &lazyCreateInfo,
+          &lazyTypeIndex);
+      if (findResult == VK_SUCCESS) {
+        allocationCreateInfo.memoryTypeBits =
+            1u << lazyTypeIndex;
+        allocationCreateInfo.flags |=
+            VMA_ALLOCATION_CREATE_DEDICATED_MEMORY_BIT;
+        lazilyAllocated = true;
+      }
+    }
 
     VmaAllocation allocation = {};
     VkImage imageHandle = {};
@@ -115,7 +200,33 @@ struct image_builder {
         m_imageType,
         m_format,
         m_arrayLayers,
-        m_aspect);
+        m_aspect,
+        imageCreateInfo,
+        lazilyAllocated);
+  }
+
+  // Creates the image without memory, to be bound into
+  // memory it shares with other images. The image does not
+  // own that memory.
+  tl::expected<std::unique_ptr<image>, VkResult>
+  build_unbound(VkDevice device, VmaAllocator allocator) {
+    auto imageCreateInfo = create_info();
+    VkImage imageHandle = {};
+    auto result = vkCreateImage(
+        device, &imageCreateInfo, nullptr, &imageHandle);
+    if (result != VK_SUCCESS) {
+      return tl::make_unexpected(result);
+    }
+
+    return std::make_unique<image>(
+        allocator,
+        VK_NULL_HANDLE,
+        imageHandle,
+        m_imageType,
+        m_format,
+        m_arrayLayers,
+        m_aspect,
+        imageCreateInfo);
   }
 
   image_builder& format(VkFormat imageFormat) {
@@ -227,6 +338,10 @@ struct image_builder {
     m_imageUsage |= VK_IMAGE_USAGE_INPUT_ATTACHMENT_BIT;
     return *this;
   }
+  image_builder& storage() {
+    m_imageUsage |= VK_IMAGE_USAGE_STORAGE_BIT;
+    return *this;
+  }
 
   image_builder& dedicated() {
     m_allocationFlags |=
@@ -265,6 +380,28 @@ struct image_builder {
   }
 
 private:
+  VkImageCreateInfo create_info() const {
+    VkImageCreateInfo imageCreateInfo = {
+        VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+    imageCreateInfo.format = m_format;
+    imageCreateInfo.imageType = m_imageType;
+    imageCreateInfo.tiling = m_tiling;
+    imageCreateInfo.samples = m_samples;
+    imageCreateInfo.mipLevels = m_mipLevels;
+    imageCreateInfo.usage = m_imageUsage;
+    imageCreateInfo.initialLayout =
+        ((m_tiling == VK_IMAGE_TILING_OPTIMAL)
+             ? VK_IMAGE_LAYOUT_UNDEFINED
+             : VK_IMAGE_LAYOUT_PREINITIALIZED);
+    imageCreateInfo.queueFamilyIndexCount = 1;
+    imageCreateInfo.pQueueFamilyIndices =
+        &m_queueFamilyIndex;
+    imageCreateInfo.sharingMode = VK_SHARING_MODE_EXCLUSIVE;
+    imageCreateInfo.arrayLayers = m_arrayLayers;
+    imageCreateInfo.extent = m_imageExtent;
+    return imageCreateInfo;
+  }
+
   VkFormat m_format = {};
   VkImageType m_imageType = {};
   VkExtent3D m_imageExtent = {};
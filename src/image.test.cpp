@@ -65,4 +65,61 @@ TEST_CASE(
       .map_error([](auto error) { REQUIRE(false); });
   REQUIRE(imagePtr->operator VkImage() != VK_NULL_HANDLE);
   REQUIRE(imagePtr->operator VmaAllocation() != nullptr);
-}
\ No newline at end of file
+}
+
+TEST_CASE("Create a transient depth attachment") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<image> imagePtr = {};
+  image_builder{}
+      .gpu_only()
+      .format(VK_FORMAT_D32_SFLOAT)
+      .image_extent(1920, 1080)
+      .depth_attachment()
+      .transient()
+      .type_2d()
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*allocatorPtr)
+      .map(move_into{imagePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(imagePtr->operator VkImage() != VK_NULL_HANDLE);
+  if (!imagePtr->lazily_allocated()) {
+    REQUIRE(imagePtr->bytes_avoided(*devicePtr) == 0);
+  }
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <tl/expected.hpp>
+#include <vector>
+#include "command_recorder.hpp"
+#include "gsl-lite.hpp"
+#include "ring_allocator.hpp"
+
+namespace vka {
+struct indirect_batch {
+  VkPipeline pipeline = {};
+  uint32_t firstCommand = {};
+  uint32_t commandCount = {};
+};
+
+// Groups indexed draws by pipeline and records each group
+// with a single vkCmdDrawIndexedIndirect, reading the
+// commands from a ring allocator built with
+// indirect_buffer(). Without the multiDrawIndirect feature
+// each group falls back to one vkCmdDrawIndexed per draw.
+// Vertex and index buffers, descriptor sets and push
+// constants must be bound by the caller and shared by every
+// draw. A nonzero firstInstance on the indirect path needs
+// the drawIndirectFirstInstance feature.
+struct indirect_batcher {
+  explicit indirect_batcher(
+      bool multiDrawIndirect,
+      uint32_t maxDrawIndirectCount =
+          std::numeric_limits<uint32_t>::max())
+      : m_multiDrawIndirect(multiDrawIndirect),
+        m_maxDrawIndirectCount(
+            std::max<uint32_t>(maxDrawIndirectCount, 1)) {}
+
+  void add(
+      VkPipeline pipeline,
+      const VkDrawIndexedIndirectCommand& command) {
+    auto it = std::find_if(
+        m_batches.begin(),
+        m_batches.end(),
+        [&](auto& batch) {
+          return batch.pipeline == pipeline;
+        });
+    if (it == m_batches.end()) {
+      m_batches.push_back({pipeline});
+      it = m_batches.end() - 1;
+    }
+    ++it->commandCount;
+    auto batchIndex =
+        static_cast<uint32_t>(it - m_batches.begin());
+    m_draws.push_back({batchIndex, command});
+    m_grouped = false;
+  }
+
+  // Keeps capacity, so steady state frames do not allocate.
+  void clear() noexcept {
+    m_batches.clear();
+    m_draws.clear();
+    m_commands.clear();
+    m_grouped = true;
+  }
+
+  // One batch per pipeline, in order of first use.
+  const std::vector<indirect_batch>& batches() {
+    group();
+    return m_batches;
+  }
+
+  // Every command, contiguous per batch and in submission
+  // order within a batch.
+  gsl::span<const VkDrawIndexedIndirectCommand> commands() {
+    group();
+    return m_commands;
+  }
+
+  // Binds each batch's pipeline and draws it. On the
+  // indirect path the commands are copied into one
+  // allocation from indirectRing.
+  tl::expected<void, ring_out_of_space> record(
+      command_recorder& recorder,
+      ring_allocator& indirectRing) {
+    group();
+    if (m_commands.empty()) {
+      return {};
+    }
+    if (!m_multiDrawIndirect) {
+      record_direct(recorder);
+      return {};
+    }
+    return indirectRing
+        .push(
+            gsl::span<const VkDrawIndexedIndirectCommand>(
+                m_commands),
+            alignof(uint32_t))
+        .map([&](ring_allocation allocation) {
+          record_indirect(recorder, allocation);
+        });
+  }
+
+  size_t size() const noexcept { return m_draws.size(); }
+
+private:
+  struct pending_draw {
+    uint32_t batchIndex = {};
+    VkDrawIndexedIndirectCommand command = {};
+  };
+
+  void group() {
+    if (m_grouped) {
+      return;
+    }
+    uint32_t first = {};
+    for (auto& batch : m_batches) {
+      batch.firstCommand = first;
+      first += batch.commandCount;
+    }
+    m_cursors.resize(m_batches.size());
+    for (size_t i = {}; i < m_batches.size(); ++i) {
+      m_cursors[i] = m_batches[i].firstCommand;
+    }
+    m_commands.resize(m_draws.size());
+    for (auto& draw : m_draws) {
+      m_commands[m_cursors[draw.batchIndex]++] =
+          draw.command;
+    }
+    m_grouped = true;
+  }
+
+  void record_indirect(
+      command_recorder& recorder,
+      const ring_allocation& allocation) {
+    constexpr auto stride = static_cast<uint32_t>(
+        sizeof(VkDrawIndexedIndirectCommand));
+    for (auto& batch : m_batches) {
+      recorder.bind_pipeline(
+          VK_PIPELINE_BIND_POINT_GRAPHICS, batch.pipeline);
+      auto remaining = batch.commandCount;
+      auto offset =
+          allocation.offset +
+          VkDeviceSize(batch.firstCommand) * stride;
+      while (remaining > 0) {
+        auto count =
+            std::min(remaining, m_maxDrawIndirectCount);
+        vkCmdDrawIndexedIndirect(
+            recorder,
+            allocation.buffer,
+            offset,
+            count,
+            stride);
+        remaining -= count;
+        offset += VkDeviceSize(count) * stride;
+      }
+    }
+  }
+
+  void record_direct(command_recorder& recorder) {
+    for (auto& batch : m_batches) {
+      recorder.bind_pipeline(
+          VK_PIPELINE_BIND_POINT_GRAPHICS, batch.pipeline);
+      auto first = m_commands.begin() + batch.firstCommand;
+      auto last = first + batch.commandCount;
+      for (auto it = first; it != last; ++it) {
+        recorder.draw_indexed(
+            it->indexCount,
+            it->instanceCount,
+            it->firstIndex,
+            it->vertexOffset,
+            it->firstInstance);
+      }
+    }
+  }
+
+  bool m_multiDrawIndirect = {};
+  uint32_t m_maxDrawIndirectCount = {};
+  std::vector<indirect_batch> m_batches = {};
+  std::vector<pending_draw> m_draws = {};
+  std::vector<VkDrawIndexedIndirectCommand> m_commands = {};
+  std::vector<uint32_t> m_cursors = {};
+  bool m_grouped = true;
+};
+}  // namespace vka
@@ -0,0 +1,47 @@
+#include "indirect_batcher.hpp"
+
+#include <catch2/catch.hpp>
+#include <cstdint>
+
+using namespace vka;
+static VkPipeline fake_pipeline(uintptr_t value) {
+  return reinterpret_cast<VkPipeline>(value);
+}
+
+static VkDrawIndexedIndirectCommand make_command(
+    uint32_t firstInstance) {
+  return {3, 1, 0, 0, firstInstance};
+}
+
+TEST_CASE("Indirect batcher groups draws by pipeline") {
+  auto pipelineA = fake_pipeline(1);
+  auto pipelineB = fake_pipeline(2);
+  indirect_batcher batcher{true};
+  batcher.add(pipelineA, make_command(0));
+  batcher.add(pipelineB, make_command(1));
+  batcher.add(pipelineA, make_command(2));
+  batcher.add(pipelineB, make_command(3));
+  batcher.add(pipelineA, make_command(4));
+  REQUIRE(batcher.size() == 5);
+
+  auto& batches = batcher.batches();
+  REQUIRE(batches.size() == 2);
+  REQUIRE(batches[0].pipeline == pipelineA);
+  REQUIRE(batches[0].firstCommand == 0);
+  REQUIRE(batches[0].commandCount == 3);
+  REQUIRE(batches[1].pipeline == pipelineB);
+  REQUIRE(batches[1].firstCommand == 3);
+  REQUIRE(batches[1].commandCount == 2);
+
+  auto commands = batcher.commands();
+  REQUIRE(commands.size() == 5);
+  uint32_t expected[] = {0, 2, 4, 1, 3};
+  for (size_t i = {}; i < 5; ++i) {
+    REQUIRE(commands[i].firstInstance == expected[i]);
+  }
+
+  batcher.clear();
+  REQUIRE(batcher.size() == 0);
+  REQUIRE(batcher.batches().empty());
+  REQUIRE(batcher.commands().empty());
+}
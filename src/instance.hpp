@@ -55,6 +55,15 @@ public:
     return *this;
   }
 
+  // Enables VK_KHR_get_physical_device_properties2, which
+  // device extensions such as VK_EXT_memory_budget or
+  // VK_KHR_timeline_semaphore require on a 1.0 instance.
+  instance_builder& physical_device_properties2() {
+    m_extensions.push_back(
+        VK_KHR_GET_PHYSICAL_DEVICE_PROPERTIES_2_EXTENSION_NAME);
+    return *this;
+  }
+
   instance_builder& add_layer(const char* name) {
     m_layers.push_back(name);
     return *this;
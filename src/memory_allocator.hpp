@@ -3,12 +3,247 @@
 #include <vk_mem_alloc.h>
 #include <vulkan/vulkan.h>
 #include <memory>
+#include <string>
+#include <string_view>
 #include <tl/expected.hpp>
+#include <tl/optional.hpp>
+#include <unordered_map>
+#include <vector>
 
 namespace vka {
+struct memory_pool {
+  explicit memory_pool(VmaAllocator allocator, VmaPool pool)
+      : m_allocator(allocator), m_pool(pool) {}
+
+  memory_pool(const memory_pool&) = delete;
+  memory_pool(memory_pool&&) = default;
+  memory_pool& operator=(const memory_pool&) = delete;
+  memory_pool& operator=(memory_pool&&) = default;
+
+  ~memory_pool() noexcept {
+    vmaDestroyPool(m_allocator, m_pool);
+  }
+
+  operator VmaPool() const noexcept { return m_pool; }
+
+  VmaPoolStats stats() const noexcept {
+    VmaPoolStats poolStats = {};
+    vmaGetPoolStats(m_allocator, m_pool, &poolStats);
+    return poolStats;
+  }
+
+private:
+  VmaAllocator m_allocator = {};
+  VmaPool m_pool = {};
+};
+
+struct memory_pool_builder {
+  tl::expected<std::unique_ptr<memory_pool>, VkResult>
+  build(VmaAllocator allocator) {
+    VmaAllocationCreateInfo allocationCreateInfo = {};
+    allocationCreateInfo.usage = m_memoryUsage;
+
+    uint32_t memoryTypeIndex = {};
+    VkResult findResult = {};
+    if (m_bufferUsage) {
+      VkBufferCreateInfo bufferCreateInfo = {
+          VK_STRUCTURE_TYPE_BUFFER_CREATE_INFO};
+      bufferCreateInfo.size = 1;
+      bufferCreateInfo.usage = m_bufferUsage;
+      findResult = vmaFindMemoryTypeIndexForBufferInfo(
+          allocator,
+          &bufferCreateInfo,
+          &allocationCreateInfo,
+          &memoryTypeIndex);
+    } else if (m_imageUsage) {
+      VkImageCreateInfo imageCreateInfo = {
+          VK_STRUCTURE_TYPE_IMAGE_CREATE_INFO};
+      imageCreateInfo.imageType = VK_IMAGE_TYPE_2D;
+      imageCreateInfo.format = m_imageFormat;
+      imageCreateInfo.extent = {1, 1, 1};
+      imageCreateInfo.mipLevels = 1;
+      imageCreateInfo.arrayLayers = 1;
+      imageCreateInfo.samples = VK_SAMPLE_COUNT_1_BIT;
+      imageCreateInfo.tiling = VK_IMAGE_TILING_OPTIMAL;
+      imageCreateInfo.usage = m_imageUsage;
+      findResult = vmaFindMemoryTypeIndexForImageInfo(
+          allocator,
+          &imageCreateInfo,
+          &allocationCreateInfo,
+          &memoryTypeIndex);
+    } else {
+      findResult = vmaFindMemoryTypeIndex(
+          allocator,
+          UINT32_MAX,
+          &allocationCreateInfo,
+          &memoryTypeIndex);
+    }
+    if (findResult != VK_SUCCESS) {
+      return tl::make_unexpected(findResult);
+    }
+
+    VmaPoolCreateInfo createInfo = {};
+    createInfo.memoryTypeIndex = memoryTypeIndex;
+    createInfo.flags = m_poolFlags;
+    createInfo.blockSize = m_blockSize;
+    createInfo.minBlockCount = m_minBlockCount;
+    createInfo.maxBlockCount = m_maxBlockCount;
+    createInfo.frameInUseCount = m_frameInUseCount;
+
+    VmaPool poolHandle = {};
+    auto result =
+        vmaCreatePool(allocator, &createInfo, &poolHandle);
+    if (result != VK_SUCCESS) {
+      return tl::make_unexpected(result);
+    }
+    return std::make_unique<memory_pool>(
+        allocator, poolHandle);
+  }
+
+  // Selects the memory type from the buffers the pool will
+  // hold.
+  memory_pool_builder& buffer_usage(
+      VkBufferUsageFlags usage) {
+    m_bufferUsage = usage;
+    return *this;
+  }
+
+  // Selects the memory type from the images the pool will
+  // hold.
+  memory_pool_builder& image_usage(
+      VkImageUsageFlags usage,
+      VkFormat format) {
+    m_imageUsage = usage;
+    m_imageFormat = format;
+    return *this;
+  }
+
+  memory_pool_builder& block_size(VkDeviceSize size) {
+    m_blockSize = size;
+    return *this;
+  }
+
+  memory_pool_builder& block_count(
+      size_t minCount,
+      size_t maxCount) {
+    m_minBlockCount = minCount;
+    m_maxBlockCount = maxCount;
+    return *this;
+  }
+
+  // Allocations are made linearly, for ring buffer or stack
+  // usage, with no fragmentation between them.
+  memory_pool_builder& linear() {
+    m_poolFlags |= VMA_POOL_CREATE_LINEAR_ALGORITHM_BIT;
+    return *this;
+  }
+
+  memory_pool_builder& buddy() {
+    m_poolFlags |= VMA_POOL_CREATE_BUDDY_ALGORITHM_BIT;
+    return *this;
+  }
+
+  memory_pool_builder& frame_in_use_count(uint32_t count) {
+    m_frameInUseCount = count;
+    return *this;
+  }
+
+  memory_pool_builder& cpu_only() {
+    m_memoryUsage = VMA_MEMORY_USAGE_CPU_ONLY;
+    return *this;
+  }
+
+  memory_pool_builder& gpu_only() {
+    m_memoryUsage = VMA_MEMORY_USAGE_GPU_ONLY;
+    return *this;
+  }
+
+  memory_pool_builder& cpu_to_gpu() {
+    m_memoryUsage = VMA_MEMORY_USAGE_CPU_TO_GPU;
+    return *this;
+  }
+
+  memory_pool_builder& gpu_to_cpu() {
+    m_memoryUsage = VMA_MEMORY_USAGE_GPU_TO_CPU;
+    return *this;
+  }
+
+private:
+  VmaMemoryUsage m_memoryUsage = {};
+  VkBufferUsageFlags m_bufferUsage = {};
+  VkImageUsageFlags m_imageUsage = {};
+  VkFormat m_imageFormat = {};
+  VmaPoolCreateFlags m_poolFlags = {};
+  VkDeviceSize m_blockSize = {};
+  size_t m_minBlockCount = {};
+  size_t m_maxBlockCount = {};
+  uint32_t m_frameInUseCount = {};
+};
+
+struct memory_usage {
+  uint32_t blockCount = {};
+  uint32_t allocationCount = {};
+  uint32_t unusedRangeCount = {};
+  VkDeviceSize usedBytes = {};
+  VkDeviceSize unusedBytes = {};
+  VkDeviceSize largestFreeRange = {};
+  // 0 when all free space is one contiguous range, towards
+  // 1 as free space is split into many small ranges
+  float fragmentation = {};
+};
+
+inline memory_usage make_memory_usage(
+    const VmaStatInfo& info) noexcept {
+  memory_usage usage = {};
+  usage.blockCount = info.blockCount;
+  usage.allocationCount = info.allocationCount;
+  usage.unusedRangeCount = info.unusedRangeCount;
+  usage.usedBytes = info.usedBytes;
+  usage.unusedBytes = info.unusedBytes;
+  usage.largestFreeRange = info.unusedRangeCount > 0
+                               ? info.unusedRangeSizeMax
+                               : 0;
+  if (info.unusedBytes > 0) {
+    usage.fragmentation =
+        1.f - static_cast<float>(usage.largestFreeRange) /
+                  static_cast<float>(info.unusedBytes);
+  }
+  return usage;
+}
+
+struct memory_heap_stats {
+  uint32_t heapIndex = {};
+  VkDeviceSize size = {};
+  VkMemoryHeapFlags flags = {};
+  memory_usage usage = {};
+  // only filled when VK_EXT_memory_budget is enabled
+  bool hasBudget = {};
+  VkDeviceSize budget = {};
+  VkDeviceSize processUsage = {};
+};
+
+struct memory_type_stats {
+  uint32_t typeIndex = {};
+  uint32_t heapIndex = {};
+  VkMemoryPropertyFlags flags = {};
+  memory_usage usage = {};
+};
+
+struct memory_stats {
+  std::vector<memory_heap_stats> heaps = {};
+  std::vector<memory_type_stats> types = {};
+  memory_usage total = {};
+};
+
 struct allocator {
-  explicit allocator(VmaAllocator allocator)
-      : m_allocator(allocator) {}
+  explicit allocator(
+      VmaAllocator allocator,
+      VkPhysicalDevice physicalDevice = {},
+      PFN_vkGetPhysicalDeviceMemoryProperties2KHR
+          getMemoryProperties2 = {})
+      : m_allocator(allocator),
+        m_physicalDevice(physicalDevice),
+        m_getMemoryProperties2(getMemoryProperties2) {}
 
   allocator(const allocator&) = delete;
   allocator(allocator&&) = default;
@@ -16,6 +251,8 @@ struct allocator {
   allocator& operator=(allocator&&) = default;
 
   ~allocator() noexcept {
+    // pools must be gone before the allocator is
+    m_pools.clear();
     vmaDestroyAllocator(m_allocator);
   }
 
@@ -23,8 +260,114 @@ struct allocator {
     return m_allocator;
   }
 
+  // Creates a pool owned by this allocator, registered
+  // under a usage class name such as "per-frame uniforms".
+  // A name that is already registered fails with
+  // VK_ERROR_INITIALIZATION_FAILED.
+  tl::expected<VmaPool, VkResult> add_pool(
+      std::string name,
+      memory_pool_builder builder) {
+    if (m_pools.count(name) != 0) {
+      return tl::make_unexpected(
+          VK_ERROR_INITIALIZATION_FAILED);
+    }
+    auto result = builder.build(m_allocator);
+    if (!result) {
+      return tl::make_unexpected(result.error());
+    }
+    VmaPool poolHandle = **result;
+    m_pools[std::move(name)] = std::move(*result);
+    return poolHandle;
+  }
+
+  tl::optional<VmaPool> pool(std::string_view name) const {
+    auto it = m_pools.find(std::string{name});
+    if (it == m_pools.end()) {
+      return {};
+    }
+    return static_cast<VmaPool>(*it->second);
+  }
+
+  tl::optional<VmaPoolStats> pool_stats(
+      std::string_view name) const {
+    auto it = m_pools.find(std::string{name});
+    if (it == m_pools.end()) {
+      return {};
+    }
+    return it->second->stats();
+  }
+
+  // Walks every VMA block, so it is meant for telemetry
+  // rather than per-frame use.
+  memory_stats stats() const {
+    VmaStats vmaStats = {};
+    vmaCalculateStats(m_allocator, &vmaStats);
+    const VkPhysicalDeviceMemoryProperties* properties = {};
+    vmaGetMemoryProperties(m_allocator, &properties);
+
+    memory_stats result = {};
+    result.total = make_memory_usage(vmaStats.total);
+    for (uint32_t i = {}; i < properties->memoryHeapCount;
+         ++i) {
+      memory_heap_stats heap = {};
+      heap.heapIndex = i;
+      heap.size = properties->memoryHeaps[i].size;
+      heap.flags = properties->memoryHeaps[i].flags;
+      heap.usage =
+          make_memory_usage(vmaStats.memoryHeap[i]);
+      result.heaps.push_back(heap);
+    }
+    for (uint32_t i = {}; i < properties->memoryTypeCount;
+         ++i) {
+      memory_type_stats type = {};
+      type.typeIndex = i;
+      type.heapIndex =
+          properties->memoryTypes[i].heapIndex;
+      type.flags =
+          properties->memoryTypes[i].propertyFlags;
+      type.usage =
+          make_memory_usage(vmaStats.memoryType[i]);
+      result.types.push_back(type);
+    }
+    query_budget(result);
+    return result;
+  }
+
+  // Every allocation made from the pool must already be
+  // destroyed.
+  void remove_pool(std::string_view name) {
+    m_pools.erase(std::string{name});
+  }
+
 private:
+  void query_budget(memory_stats& result) const {
+#ifdef VK_EXT_memory_budget
+    if (!m_getMemoryProperties2) {
+      return;
+    }
+    VkPhysicalDeviceMemoryBudgetPropertiesEXT budget = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_BUDGET_PROPERTIES_EXT};
+    VkPhysicalDeviceMemoryProperties2KHR properties = {
+        VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_MEMORY_PROPERTIES_2_KHR};
+    properties.pNext = &budget;
+    m_getMemoryProperties2(m_physicalDevice, &properties);
+    for (auto& heap : result.heaps) {
+      heap.hasBudget = true;
+      heap.budget = budget.heapBudget[heap.heapIndex];
+      heap.processUsage =
+          budget.heapUsage[heap.heapIndex];
+    }
+#endif
+  }
+
   VmaAllocator m_allocator = {};
+  VkPhysicalDevice m_physicalDevice = {};
+  PFN_vkGetPhysicalDeviceMemoryProperties2KHR
+      m_getMemoryProperties2 = {};
+  std::unordered_map<
+      std::string,
+      std::unique_ptr<memory_pool>>
+      m_pools = {};
 };
 
 struct allocator_builder {
@@ -36,6 +379,20 @@ struct allocator_builder {
     createInfo.preferredLargeHeapBlockSize =
         m_preferredBlockSize;
 
+    PFN_vkGetPhysicalDeviceMemoryProperties2KHR
+        getMemoryProperties2 = {};
+    if (m_budgetInstance != VK_NULL_HANDLE) {
+      getMemoryProperties2 = reinterpret_cast<
+          PFN_vkGetPhysicalDeviceMemoryProperties2KHR>(
+          vkGetInstanceProcAddr(
+              m_budgetInstance,
+              "vkGetPhysicalDeviceMemoryProperties2KHR"));
+      if (!getMemoryProperties2) {
+        return tl::make_unexpected(
+            VK_ERROR_EXTENSION_NOT_PRESENT);
+      }
+    }
+
     VmaAllocator allocatorHandle = {};
     auto result =
         vmaCreateAllocator(&createInfo, &allocatorHandle);
@@ -43,7 +400,10 @@ struct allocator_builder {
       return tl::make_unexpected(result);
     }
 
-    return std::make_unique<allocator>(allocatorHandle);
+    return std::make_unique<allocator>(
+        allocatorHandle,
+        m_physicalDevice,
+        getMemoryProperties2);
   }
 
   allocator_builder& physical_device(
@@ -63,9 +423,20 @@ struct allocator_builder {
     return *this;
   }
 
+  // The device must have been created with
+  // VK_EXT_memory_budget enabled, and instance with
+  // VK_KHR_get_physical_device_properties2 (see
+  // instance_builder::physical_device_properties2()); heap
+  // budgets are then reported by allocator::stats().
+  allocator_builder& memory_budget(VkInstance instance) {
+    m_budgetInstance = instance;
+    return *this;
+  }
+
 private:
   VkPhysicalDevice m_physicalDevice = {};
   VkDevice m_device = {};
   VkDeviceSize m_preferredBlockSize = {};
+  VkInstance m_budgetInstance = {};
 };
 }  // namespace vka
\ No newline at end of file
@@ -1,6 +1,7 @@
 #include "memory_allocator.hpp"
 
 #include <catch2/catch.hpp>
+#include "buffer.hpp"
 #include "device.hpp"
 #include "instance.hpp"
 #include "move_into.hpp"
@@ -48,4 +49,85 @@ TEST_CASE("Create an allocator") {
       .map(move_into{allocatorPtr})
       .map_error([](auto error) { REQUIRE(false); });
   REQUIRE(allocatorPtr->operator VmaAllocator() != nullptr);
+}
+
+TEST_CASE("Create a named linear pool and allocate from it") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VmaPool uniformPool = {};
+  allocatorPtr
+      ->add_pool(
+          "per-frame uniforms",
+          memory_pool_builder{}
+              .cpu_to_gpu()
+              .buffer_usage(VK_BUFFER_USAGE_UNIFORM_BUFFER_BIT)
+              .block_size(1024 * 1024)
+              .block_count(1, 1)
+              .linear())
+      .map(move_into{uniformPool})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(uniformPool != nullptr);
+  REQUIRE(allocatorPtr->pool("per-frame uniforms"));
+  auto duplicate = allocatorPtr->add_pool(
+      "per-frame uniforms",
+      memory_pool_builder{}.cpu_to_gpu());
+  REQUIRE(!duplicate);
+  REQUIRE(
+      *allocatorPtr->pool("per-frame uniforms") ==
+      uniformPool);
+  REQUIRE(!allocatorPtr->pool("static meshes"));
+
+  std::unique_ptr<buffer> bufferPtr = {};
+  buffer_builder{}
+      .size(256)
+      .cpu_to_gpu()
+      .uniform_buffer()
+      .memory_pool(uniformPool)
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*allocatorPtr)
+      .map(move_into{bufferPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+  auto stats = allocatorPtr->pool_stats("per-frame uniforms");
+  REQUIRE(stats);
+  REQUIRE(stats->allocationCount == 1);
+
+  bufferPtr.reset();
+  allocatorPtr->remove_pool("per-frame uniforms");
+  REQUIRE(!allocatorPtr->pool("per-frame uniforms"));
 }
\ No newline at end of file
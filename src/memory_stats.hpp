@@ -0,0 +1,113 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <chrono>
+#include <fstream>
+#include <nlohmann/json.hpp>
+#include <tl/expected.hpp>
+#include "clock.hpp"
+#include "io.hpp"
+#include "memory_allocator.hpp"
+
+namespace vka {
+inline void to_json(
+    nlohmann::json& j,
+    const memory_usage& usage) {
+  j = nlohmann::json{
+      {"blockCount", usage.blockCount},
+      {"allocationCount", usage.allocationCount},
+      {"unusedRangeCount", usage.unusedRangeCount},
+      {"usedBytes", usage.usedBytes},
+      {"unusedBytes", usage.unusedBytes},
+      {"largestFreeRange", usage.largestFreeRange},
+      {"fragmentation", usage.fragmentation}};
+}
+
+inline void to_json(
+    nlohmann::json& j,
+    const memory_heap_stats& heap) {
+  j = nlohmann::json{
+      {"heapIndex", heap.heapIndex},
+      {"size", heap.size},
+      {"deviceLocal",
+       (heap.flags & VK_MEMORY_HEAP_DEVICE_LOCAL_BIT) != 0},
+      {"usage", heap.usage}};
+  if (heap.hasBudget) {
+    j["budget"] = heap.budget;
+    j["processUsage"] = heap.processUsage;
+  }
+}
+
+inline void to_json(
+    nlohmann::json& j,
+    const memory_type_stats& type) {
+  j = nlohmann::json{
+      {"typeIndex", type.typeIndex},
+      {"heapIndex", type.heapIndex},
+      {"propertyFlags", type.flags},
+      {"usage", type.usage}};
+}
+
+inline void to_json(
+    nlohmann::json& j,
+    const memory_stats& stats) {
+  j = nlohmann::json{
+      {"total", stats.total},
+      {"heaps", stats.heaps},
+      {"types", stats.types}};
+}
+
+// Appends allocator statistics to a file as one JSON object
+// per line, at most once per interval.
+struct memory_stats_dump {
+  explicit memory_stats_dump(
+      io::fs::path filePath,
+      Clock::duration interval = OneSecond)
+      : m_filePath(std::move(filePath)),
+        m_interval(interval),
+        m_start(Clock::now()),
+        m_lastDump(m_start - interval) {}
+
+  // Call once per frame; only writes when the interval has
+  // elapsed since the previous dump.
+  tl::expected<void, io::path_error> update(
+      const allocator& memoryAllocator,
+      Clock::time_point now = Clock::now()) {
+    if (now - m_lastDump < m_interval) {
+      return {};
+    }
+    m_lastDump = now;
+    return write(memoryAllocator, now);
+  }
+
+  tl::expected<void, io::path_error> write(
+      const allocator& memoryAllocator,
+      Clock::time_point now = Clock::now()) {
+    std::ofstream fileStream(
+        m_filePath,
+        std::ios_base::out | std::ios_base::app);
+    if (!fileStream) {
+      return tl::make_unexpected(
+          io::path_error::PathProblem);
+    }
+    auto elapsed = std::chrono::duration<double>(
+                       now - m_start)
+                       .count();
+    nlohmann::json j = {
+        {"time", elapsed},
+        {"stats", memoryAllocator.stats()}};
+    fileStream << j.dump() << '\n';
+    if (fileStream.bad() || fileStream.fail()) {
+      return tl::make_unexpected(
+          io::path_error::WriteProblem);
+    }
+    return {};
+  }
+
+private:
+  io::fs::path m_filePath = {};
+  Clock::duration m_interval = {};
+  Clock::time_point m_start = {};
+  Clock::time_point m_lastDump = {};
+};
+}  // namespace vka
@@ -0,0 +1,50 @@
+#include "memory_stats.hpp"
+
+#include <catch2/catch.hpp>
+
+using namespace vka;
+TEST_CASE("Memory usage with one free range") {
+  VmaStatInfo info = {};
+  info.blockCount = 1;
+  info.allocationCount = 2;
+  info.unusedRangeCount = 1;
+  info.usedBytes = 768;
+  info.unusedBytes = 256;
+  info.unusedRangeSizeMax = 256;
+  auto usage = make_memory_usage(info);
+  REQUIRE(usage.blockCount == 1);
+  REQUIRE(usage.allocationCount == 2);
+  REQUIRE(usage.largestFreeRange == 256);
+  REQUIRE(usage.fragmentation == Approx(0.f));
+}
+
+TEST_CASE("Memory usage with split free ranges") {
+  VmaStatInfo info = {};
+  info.unusedRangeCount = 4;
+  info.unusedBytes = 1024;
+  info.unusedRangeSizeMax = 256;
+  auto usage = make_memory_usage(info);
+  REQUIRE(usage.fragmentation == Approx(0.75f));
+}
+
+TEST_CASE("Memory usage with no free space") {
+  VmaStatInfo info = {};
+  info.usedBytes = 1024;
+  info.unusedRangeSizeMax = 4096;
+  auto usage = make_memory_usage(info);
+  REQUIRE(usage.largestFreeRange == 0);
+  REQUIRE(usage.fragmentation == Approx(0.f));
+}
+
+TEST_CASE("Memory stats serialize to json") {
+  memory_stats stats = {};
+  memory_heap_stats heap = {};
+  heap.size = 4096;
+  heap.flags = VK_MEMORY_HEAP_DEVICE_LOCAL_BIT;
+  stats.heaps.push_back(heap);
+  nlohmann::json j = stats;
+  REQUIRE(j["heaps"].size() == 1);
+  REQUIRE(j["heaps"][0]["deviceLocal"] == true);
+  REQUIRE(j["heaps"][0].count("budget") == 0);
+  REQUIRE(j["total"]["usedBytes"] == 0);
+}
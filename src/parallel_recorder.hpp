@@ -0,0 +1,103 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <functional>
+#include <mutex>
+#include <tl/expected.hpp>
+#include <vector>
+#include "command_pool_manager.hpp"
+#include "work_stealing_pool.hpp"
+
+namespace vka {
+struct secondary_inheritance {
+  VkRenderPass renderPass = {};
+  uint32_t subpass = {};
+  VkFramebuffer framebuffer = {};
+};
+
+// Records draws [first, last) into a secondary command
+// buffer that is already begun inside the render pass.
+using chunk_recorder = std::function<
+    void(VkCommandBuffer cmd, size_t first, size_t last)>;
+
+// Splits drawCount draws into chunks, records each chunk
+// into a secondary command buffer from the recording
+// worker's own pool, and executes them in draw order from
+// primary. primary must be inside a render pass begun with
+// VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS, and the
+// manager must have at least one thread per worker.
+inline tl::expected<void, VkResult> record_parallel(
+    work_stealing_pool& workers,
+    command_pool_manager& commandPools,
+    VkCommandBuffer primary,
+    secondary_inheritance inheritance,
+    size_t drawCount,
+    size_t chunkSize,
+    const chunk_recorder& recordChunk) {
+  if (drawCount == 0) {
+    return {};
+  }
+  chunkSize = std::max<size_t>(chunkSize, 1);
+  auto chunkCount = (drawCount + chunkSize - 1) / chunkSize;
+  std::vector<VkCommandBuffer> secondaries(chunkCount);
+  std::mutex errorMutex = {};
+  VkResult error = VK_SUCCESS;
+  auto set_error = [&](VkResult result) {
+    std::lock_guard<std::mutex> lock(errorMutex);
+    if (error == VK_SUCCESS) {
+      error = result;
+    }
+  };
+
+  workers.parallel_for(
+      chunkCount, [&](uint32_t workerIndex, size_t chunk) {
+        auto cmdResult = commandPools.acquire(
+            workerIndex, VK_COMMAND_BUFFER_LEVEL_SECONDARY);
+        if (!cmdResult) {
+          set_error(cmdResult.error());
+          return;
+        }
+        auto cmd = *cmdResult;
+
+        VkCommandBufferInheritanceInfo inheritanceInfo = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_INHERITANCE_INFO};
+        inheritanceInfo.renderPass = inheritance.renderPass;
+        inheritanceInfo.subpass = inheritance.subpass;
+        inheritanceInfo.framebuffer =
+            inheritance.framebuffer;
+        VkCommandBufferBeginInfo beginInfo = {
+            VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+        beginInfo.flags =
+            VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT |
+            VK_COMMAND_BUFFER_USAGE_RENDER_PASS_CONTINUE_BIT;
+        beginInfo.pInheritanceInfo = &inheritanceInfo;
+        auto beginResult =
+            vkBeginCommandBuffer(cmd, &beginInfo);
+        if (beginResult != VK_SUCCESS) {
+          set_error(beginResult);
+          return;
+        }
+
+        auto first = chunk * chunkSize;
+        auto last = std::min(first + chunkSize, drawCount);
+        recordChunk(cmd, first, last);
+
+        auto endResult = vkEndCommandBuffer(cmd);
+        if (endResult != VK_SUCCESS) {
+          set_error(endResult);
+          return;
+        }
+        secondaries[chunk] = cmd;
+      });
+
+  if (error != VK_SUCCESS) {
+    return tl::make_unexpected(error);
+  }
+  vkCmdExecuteCommands(
+      primary,
+      static_cast<uint32_t>(secondaries.size()),
+      secondaries.data());
+  return {};
+}
+}  // namespace vka
@@ -0,0 +1,157 @@
+#include "parallel_recorder.hpp"
+
+#include <atomic>
+#include <catch2/catch.hpp>
+#include "device.hpp"
+#include "framebuffer.hpp"
+#include "image.hpp"
+#include "image_view.hpp"
+#include "instance.hpp"
+#include "memory_allocator.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue_family.hpp"
+#include "render_pass.hpp"
+
+using namespace vka;
+TEST_CASE("Record secondary command buffers in parallel") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<image> imagePtr = {};
+  image_builder{}
+      .gpu_only()
+      .format(VK_FORMAT_R8G8B8A8_UNORM)
+      .image_extent(100, 100)
+      .color_attachment()
+      .type_2d()
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*allocatorPtr)
+      .map(move_into{imagePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<image_view> viewPtr = {};
+  image_view_builder{}
+      .from_image(*imagePtr)
+      .build(*devicePtr)
+      .map(move_into{viewPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<render_pass> renderPassPtr = {};
+  render_pass_builder{}
+      .add_attachment(
+          attachment_builder{}
+              .initial_layout(VK_IMAGE_LAYOUT_UNDEFINED)
+              .final_layout(
+                  VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+              .format(VK_FORMAT_R8G8B8A8_UNORM)
+              .loadOp(VK_ATTACHMENT_LOAD_OP_CLEAR)
+              .storeOp(VK_ATTACHMENT_STORE_OP_STORE)
+              .build())
+      .add_subpass(
+          subpass_builder{}
+              .color_attachment(
+                  0,
+                  VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL)
+              .build())
+      .build(*devicePtr)
+      .map(move_into{renderPassPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<framebuffer> framebufferPtr = {};
+  framebuffer_builder{}
+      .render_pass(*renderPassPtr)
+      .dimensions(100, 100)
+      .attachments({*viewPtr})
+      .build(*devicePtr)
+      .map(move_into{framebufferPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  work_stealing_pool workers{3};
+  std::unique_ptr<command_pool_manager> commandPoolsPtr =
+      {};
+  command_pool_manager_builder{}
+      .queue_family_index(queueFamily.familyIndex)
+      .thread_count(workers.worker_count())
+      .build(*devicePtr)
+      .map(move_into{commandPoolsPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(commandPoolsPtr->begin_frame(0));
+
+  VkCommandBuffer primary = {};
+  commandPoolsPtr->acquire(0)
+      .map(move_into{primary})
+      .map_error([](auto error) { REQUIRE(false); });
+  VkCommandBufferBeginInfo beginInfo = {
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+  REQUIRE(
+      vkBeginCommandBuffer(primary, &beginInfo) ==
+      VK_SUCCESS);
+
+  VkClearValue clearValue = {};
+  VkRenderPassBeginInfo renderPassInfo = {
+      VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+  renderPassInfo.renderPass = *renderPassPtr;
+  renderPassInfo.framebuffer = *framebufferPtr;
+  renderPassInfo.renderArea = {{0, 0}, {100, 100}};
+  renderPassInfo.clearValueCount = 1;
+  renderPassInfo.pClearValues = &clearValue;
+  vkCmdBeginRenderPass(
+      primary,
+      &renderPassInfo,
+      VK_SUBPASS_CONTENTS_SECONDARY_COMMAND_BUFFERS);
+
+  secondary_inheritance inheritance = {};
+  inheritance.renderPass = *renderPassPtr;
+  inheritance.framebuffer = *framebufferPtr;
+  std::atomic<size_t> recordedDraws = {};
+  REQUIRE(record_parallel(
+      workers,
+      *commandPoolsPtr,
+      primary,
+      inheritance,
+      100,
+      16,
+      [&](VkCommandBuffer cmd, size_t first, size_t last) {
+        recordedDraws += last - first;
+      }));
+  vkCmdEndRenderPass(primary);
+  REQUIRE(vkEndCommandBuffer(primary) == VK_SUCCESS);
+  REQUIRE(recordedDraws == 100);
+}
@@ -65,7 +65,7 @@ enum class device_features {
 };
 
 inline void to_vulkan_feature(
-    VkPhysicalDeviceFeatures vulkanFeatures,
+    VkPhysicalDeviceFeatures& vulkanFeatures,
     device_features feature) {
   switch (feature) {
     case device_features::robustBufferAccess:
@@ -1,17 +1,68 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include <memory>
+#include <mutex>
 #include <tl/expected.hpp>
+#include <unordered_map>
+#include "gsl-lite.hpp"
 #include "queue_family.hpp"
 
 namespace vka {
+namespace detail {
+// One lock per VkQueue, shared by every wrapper of it.
+inline std::shared_ptr<std::mutex> queue_mutex(
+    VkQueue queueHandle) {
+  static std::mutex registryMutex = {};
+  static std::unordered_map<
+      VkQueue,
+      std::weak_ptr<std::mutex>>
+      registry = {};
+  std::lock_guard<std::mutex> lock(registryMutex);
+  auto& entry = registry[queueHandle];
+  auto mutexPtr = entry.lock();
+  if (!mutexPtr) {
+    mutexPtr = std::make_shared<std::mutex>();
+    entry = mutexPtr;
+  }
+  return mutexPtr;
+}
+}  // namespace detail
+
 struct queue {
   queue() = default;
   explicit queue(VkQueue queueHandle)
-      : m_queue(queueHandle) {}
+      : m_queue(queueHandle),
+        m_mutex(detail::queue_mutex(queueHandle)) {}
+
+  // Raw use of the handle, e.g. vkQueuePresentKHR, must
+  // hold lock() for the duration of the call.
   operator VkQueue() { return m_queue; }
 
+  std::unique_lock<std::mutex> lock() {
+    return std::unique_lock<std::mutex>(*m_mutex);
+  }
+
+  // Every wrapper of the same VkQueue shares one lock, so
+  // any number of them may submit from different threads.
+  tl::expected<void, VkResult> submit(
+      gsl::span<const VkSubmitInfo> submits,
+      VkFence fence = VK_NULL_HANDLE) {
+    std::lock_guard<std::mutex> lock(*m_mutex);
+    auto result = vkQueueSubmit(
+        m_queue,
+        static_cast<uint32_t>(submits.size()),
+        submits.data(),
+        fence);
+    if (result != VK_SUCCESS) {
+      return tl::make_unexpected(result);
+    }
+    return {};
+  }
+
 private:
   VkQueue m_queue = {};
+  std::shared_ptr<std::mutex> m_mutex =
+      std::make_shared<std::mutex>();
 };
 
 struct queue_index_out_of_bounds {};
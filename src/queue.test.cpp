@@ -1,6 +1,8 @@
 #include "queue.hpp"
 
 #include <catch2/catch.hpp>
+#include <chrono>
+#include <future>
 #include "device.hpp"
 #include "instance.hpp"
 #include "move_into.hpp"
@@ -9,6 +11,21 @@
 #include "queue_family.hpp"
 
 using namespace vka;
+TEST_CASE("Wrappers of one VkQueue share a lock") {
+  auto queueHandle = reinterpret_cast<VkQueue>(1);
+  queue first{queueHandle};
+  queue second{queueHandle};
+  auto held = first.lock();
+  auto waiter = std::async(std::launch::async, [&] {
+    return second.lock().owns_lock();
+  });
+  REQUIRE(
+      waiter.wait_for(std::chrono::milliseconds(50)) ==
+      std::future_status::timeout);
+  held.unlock();
+  REQUIRE(waiter.get());
+}
+
 TEST_CASE("Get queue from device") {
   platform::glfw::init();
   std::unique_ptr<instance> instancePtr = {};
@@ -15,8 +15,10 @@ struct queue_family {
 inline tl::optional<uint32_t> queue_flag_match(
     tl::optional<uint32_t> index,
     VkQueueFlags supported,
-    VkQueueFlags required) {
-  if ((supported & required) == required) {
+    VkQueueFlags required,
+    VkQueueFlags excluded = {}) {
+  if ((supported & required) == required &&
+      (supported & excluded) == 0) {
     return index;
   }
   return {};
@@ -51,7 +53,6 @@ struct queue_family_builder {
   using result_type =
       tl::expected<queue_family, no_matching_queue_family>;
   result_type build(VkPhysicalDevice physicalDevice) {
-    result_type result;
     uint32_t count = {};
     vkGetPhysicalDeviceQueueFamilyProperties(
         physicalDevice, &count, nullptr);
@@ -60,9 +61,11 @@ struct queue_family_builder {
     vkGetPhysicalDeviceQueueFamilyProperties(
         physicalDevice, &count, properties.data());
 
+    bool found = {};
     for (uint32_t i = {}; i < count; ++i) {
       const auto& prop = properties[i];
-      queue_flag_match(i, prop.queueFlags, m_queueFlags)
+      queue_flag_match(
+          i, prop.queueFlags, m_queueFlags, m_excludedFlags)
           .and_then([&](auto value) {
             return queue_present_match(
                 value,
@@ -71,13 +74,13 @@ struct queue_family_builder {
                 m_presentRequired);
           })
           .map(move_into{m_family.familyIndex})
-          .or_else(move_value_into<result_type>{
-              tl::make_unexpected(
-                  no_matching_queue_family{}),
-              result});
+          .map([&found](auto) { found = true; });
     }
-    result = m_family;
-    return result;
+    if (!found) {
+      return tl::make_unexpected(
+          no_matching_queue_family{});
+    }
+    return m_family;
   }
 
   queue_family_builder& present_support(
@@ -102,6 +105,15 @@ struct queue_family_builder {
     return *this;
   }
 
+  // Only matches families without graphics or compute
+  // support, i.e. a dedicated DMA/copy queue.
+  queue_family_builder& dedicated_transfer() {
+    m_queueFlags |= VK_QUEUE_TRANSFER_BIT;
+    m_excludedFlags |=
+        VK_QUEUE_GRAPHICS_BIT | VK_QUEUE_COMPUTE_BIT;
+    return *this;
+  }
+
   queue_family_builder& queue(float priority) {
     m_family.queuePriorities.push_back(priority);
     return *this;
@@ -111,6 +123,7 @@ private:
   VkSurfaceKHR m_surface = {};
   queue_family m_family = {};
   VkQueueFlags m_queueFlags = {};
+  VkQueueFlags m_excludedFlags = {};
   bool m_presentRequired = {};
 };
 }  // namespace vka
\ No newline at end of file
@@ -0,0 +1,808 @@
+#pragma once
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <tl/expected.hpp>
+#include <tl/optional.hpp>
+#include <vector>
+#include "barrier_batcher.hpp"
+#include "framebuffer.hpp"
+#include "gsl-lite.hpp"
+#include "image.hpp"
+#include "image_view.hpp"
+#include "render_pass.hpp"
+#include "resource_tracker.hpp"
+#include "sync_helper.hpp"
+
+namespace vka {
+using graph_resource = uint32_t;
+
+struct graph_access {
+  graph_resource resource = {};
+  ThsvsAccessType access = THSVS_ACCESS_NONE;
+  bool attachment = {};
+  VkAttachmentLoadOp loadOp =
+      VK_ATTACHMENT_LOAD_OP_DONT_CARE;
+  VkClearValue clearValue = {};
+
+  // Whether the pass needs what earlier passes wrote.
+  // Attachments that are not loaded are overwritten.
+  bool reads_contents() const noexcept {
+    return !attachment ||
+           loadOp == VK_ATTACHMENT_LOAD_OP_LOAD;
+  }
+};
+
+// One pass of a render_graph. Its color and depth
+// attachments make up a single-subpass render pass; other
+// accesses only get barriers.
+struct graph_pass {
+  graph_pass& color(
+      graph_resource target,
+      VkAttachmentLoadOp loadOp =
+          VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+      VkClearValue clearValue = {}) {
+    auto access = THSVS_ACCESS_COLOR_ATTACHMENT_WRITE;
+    if (loadOp == VK_ATTACHMENT_LOAD_OP_LOAD) {
+      access = THSVS_ACCESS_COLOR_ATTACHMENT_READ_WRITE;
+    }
+    m_accesses.push_back(
+        {target, access, true, loadOp, clearValue});
+    return *this;
+  }
+
+  graph_pass& depth(
+      graph_resource target,
+      VkAttachmentLoadOp loadOp =
+          VK_ATTACHMENT_LOAD_OP_DONT_CARE,
+      VkClearValue clearValue = {}) {
+    m_accesses.push_back(
+        {target,
+         THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE,
+         true,
+         loadOp,
+         clearValue});
+    return *this;
+  }
+
+  graph_pass& sampled(graph_resource source) {
+    return read(
+        source,
+        THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER);
+  }
+
+  graph_pass& read(
+      graph_resource source,
+      ThsvsAccessType access) {
+    m_accesses.push_back({source, access});
+    return *this;
+  }
+
+  graph_pass& write(
+      graph_resource target,
+      ThsvsAccessType access) {
+    m_accesses.push_back({target, access});
+    return *this;
+  }
+
+  // Keeps the pass even if nothing the graph outputs
+  // depends on it.
+  graph_pass& side_effects() {
+    m_sideEffects = true;
+    return *this;
+  }
+
+  // Records the pass's commands, inside its render pass if
+  // it has attachments.
+  graph_pass& record(
+      std::function<void(VkCommandBuffer)> recordFunction) {
+    m_record = std::move(recordFunction);
+    return *this;
+  }
+
+  const std::vector<graph_access>& accesses() const {
+    return m_accesses;
+  }
+
+  bool has_side_effects() const noexcept {
+    return m_sideEffects;
+  }
+
+  const std::function<void(VkCommandBuffer)>& recorder()
+      const {
+    return m_record;
+  }
+
+private:
+  std::vector<graph_access> m_accesses = {};
+  bool m_sideEffects = {};
+  std::function<void(VkCommandBuffer)> m_record = {};
+};
+
+// A block of memory needed from the first to the last pass
+// position of its lifetime.
+struct alias_block {
+  VkDeviceSize size = {};
+  VkDeviceSize alignment = 1;
+  uint32_t first = {};
+  uint32_t last = {};
+};
+
+// Places blocks, largest first, at the lowest offset not
+// overlapping any placed block whose lifetime overlaps
+// theirs. Returns the offsets and sets totalSize to the
+// memory needed for all of them.
+inline std::vector<VkDeviceSize> place_aliased(
+    const std::vector<alias_block>& blocks,
+    VkDeviceSize& totalSize) {
+  std::vector<uint32_t> order(blocks.size());
+  for (uint32_t i = {}; i < order.size(); ++i) {
+    order[i] = i;
+  }
+  std::stable_sort(
+      order.begin(), order.end(), [&](auto a, auto b) {
+        return blocks[a].size > blocks[b].size;
+      });
+
+  std::vector<VkDeviceSize> offsets(blocks.size());
+  std::vector<uint32_t> placed = {};
+  totalSize = 0;
+  for (auto index : order) {
+    auto& block = blocks[index];
+    VkDeviceSize offset = {};
+    auto moved = true;
+    while (moved) {
+      moved = false;
+      for (auto other : placed) {
+        auto& otherBlock = blocks[other];
+        auto livesTogether =
+            block.first <= otherBlock.last &&
+            otherBlock.first <= block.last;
+        auto otherEnd = offsets[other] + otherBlock.size;
+        if (livesTogether && offset < otherEnd &&
+            offsets[other] < offset + block.size) {
+          offset = (otherEnd + block.alignment - 1) /
+                   block.alignment * block.alignment;
+          moved = true;
+        }
+      }
+    }
+    offsets[index] = offset;
+    placed.push_back(index);
+    totalSize = std::max(totalSize, offset + block.size);
+  }
+  return offsets;
+}
+
+// A frame graph over render_pass_builder,
+// framebuffer_builder and image_builder. Passes declare the
+// images they read and write; compile() orders them, culls
+// the ones no output depends on, and creates the transient
+// images, aliasing those whose lifetimes do not overlap in
+// shared memory. execute() records the passes with the
+// barriers and layout transitions sync_helper derives from
+// their accesses.
+struct render_graph {
+  render_graph() = default;
+  render_graph(const render_graph&) = delete;
+  render_graph(render_graph&&) = delete;
+  render_graph& operator=(const render_graph&) = delete;
+  render_graph& operator=(render_graph&&) = delete;
+
+  ~render_graph() noexcept { release(); }
+
+  // An image the graph creates and owns. Usage flags
+  // needed by the passes are added to the builder.
+  graph_resource create_image(image_builder builder) {
+    graph_image resource = {};
+    resource.builder = builder;
+    m_images.push_back(std::move(resource));
+    return static_cast<graph_resource>(m_images.size() - 1);
+  }
+
+  // An image owned elsewhere, e.g. a swapchain image, last
+  // accessed as currentAccess. Its state is kept between
+  // executions.
+  graph_resource import_image(
+      VkImage imageHandle,
+      VkImageView view,
+      VkFormat format,
+      VkExtent2D extent,
+      VkImageAspectFlags aspectMask,
+      ThsvsAccessType currentAccess = THSVS_ACCESS_NONE) {
+    graph_image resource = {};
+    resource.imageHandle = imageHandle;
+    resource.view = view;
+    resource.format = format;
+    resource.extent = extent;
+    resource.aspectMask = aspectMask;
+    resource.currentAccess = currentAccess;
+    m_images.push_back(std::move(resource));
+    return static_cast<graph_resource>(m_images.size() - 1);
+  }
+
+  // Marks resource as a result of the graph, left in
+  // finalAccess after execute().
+  void output(
+      graph_resource resource,
+      ThsvsAccessType finalAccess) {
+    m_images[resource].output = true;
+    m_images[resource].finalAccess = finalAccess;
+  }
+
+  uint32_t add_pass(graph_pass pass) {
+    m_passes.push_back(std::move(pass));
+    return static_cast<uint32_t>(m_passes.size() - 1);
+  }
+
+  // Culls and orders the passes and works out each
+  // resource's lifetime; compile() starts with it.
+  void plan() {
+    auto passCount = static_cast<uint32_t>(m_passes.size());
+    std::vector<std::vector<uint32_t>> dependencies(
+        passCount);
+    std::vector<std::vector<uint32_t>> producers(passCount);
+    std::vector<tl::optional<uint32_t>> writers(
+        m_images.size());
+    std::vector<std::vector<uint32_t>> readers(
+        m_images.size());
+    for (uint32_t pass = {}; pass < passCount; ++pass) {
+      for (auto& access : m_passes[pass].accesses()) {
+        auto& writer = writers[access.resource];
+        if (writer && *writer != pass) {
+          dependencies[pass].push_back(*writer);
+          if (access.reads_contents()) {
+            producers[pass].push_back(*writer);
+          }
+        }
+        if (!is_write_access(access.access)) {
+          readers[access.resource].push_back(pass);
+          continue;
+        }
+        for (auto reader : readers[access.resource]) {
+          if (reader != pass) {
+            dependencies[pass].push_back(reader);
+          }
+        }
+        readers[access.resource].clear();
+        writer = pass;
+      }
+    }
+
+    // keep what the outputs are made from
+    m_kept.assign(passCount, false);
+    std::vector<uint32_t> pending = {};
+    for (uint32_t pass = {}; pass < passCount; ++pass) {
+      if (m_passes[pass].has_side_effects()) {
+        pending.push_back(pass);
+      }
+    }
+    for (graph_resource resource = {};
+         resource < m_images.size();
+         ++resource) {
+      if (m_images[resource].output && writers[resource]) {
+        pending.push_back(*writers[resource]);
+      }
+    }
+    while (!pending.empty()) {
+      auto pass = pending.back();
+      pending.pop_back();
+      if (m_kept[pass]) {
+        continue;
+      }
+      m_kept[pass] = true;
+      pending.insert(
+          pending.end(),
+          producers[pass].begin(),
+          producers[pass].end());
+    }
+
+    // Kahn's algorithm, preferring the ready pass whose
+    // dependencies ran last so intermediate images are
+    // short-lived and can share memory.
+    std::vector<int64_t> position(passCount, -1);
+    m_order.clear();
+    for (;;) {
+      tl::optional<uint32_t> best = {};
+      int64_t bestLatest = -1;
+      for (uint32_t pass = {}; pass < passCount; ++pass) {
+        if (!m_kept[pass] || position[pass] >= 0) {
+          continue;
+        }
+        auto ready = true;
+        int64_t latest = -1;
+        for (auto dependency : dependencies[pass]) {
+          if (!m_kept[dependency]) {
+            continue;
+          }
+          ready = ready && position[dependency] >= 0;
+          latest = std::max(latest, position[dependency]);
+        }
+        if (ready && (!best || latest > bestLatest)) {
+          best = pass;
+          bestLatest = latest;
+        }
+      }
+      if (!best) {
+        break;
+      }
+      position[*best] =
+          static_cast<int64_t>(m_order.size());
+      m_order.push_back(*best);
+    }
+
+    for (auto& resource : m_images) {
+      resource.used = false;
+    }
+    for (uint32_t i = {}; i < m_order.size(); ++i) {
+      for (auto& access : m_passes[m_order[i]].accesses()) {
+        auto& resource = m_images[access.resource];
+        if (!resource.used) {
+          resource.first = i;
+        }
+        resource.used = true;
+        resource.last = i;
+      }
+    }
+    for (auto& resource : m_images) {
+      if (resource.output) {
+        resource.last =
+            static_cast<uint32_t>(m_order.size());
+      }
+    }
+  }
+
+  tl::expected<void, VkResult> compile(
+      VkDevice device,
+      VmaAllocator allocator) {
+    release();
+    m_allocator = allocator;
+    plan();
+
+    auto result = create_images(device, allocator);
+    if (result) {
+      result = create_render_passes(device);
+    }
+    if (!result) {
+      release();
+    }
+    return result;
+  }
+
+  // Records the kept passes in order; requires a
+  // successful compile(). Transient images start each
+  // execution with undefined contents.
+  void execute(VkCommandBuffer commandBuffer) {
+    Expects(m_compiledPasses.size() == m_order.size());
+    barrier_batcher barriers{commandBuffer};
+    std::vector<bool> begun(m_images.size());
+    std::vector<ThsvsAccessType> previous = {};
+    for (uint32_t i = {}; i < m_order.size(); ++i) {
+      auto& pass = m_passes[m_order[i]];
+      for (auto& access : pass.accesses()) {
+        auto& resource = m_images[access.resource];
+        auto discardContents = false;
+        if (!begun[access.resource]) {
+          begun[access.resource] = true;
+          discardContents = !resource.imported();
+          // memory shared with other images must be done
+          // with before it is reused
+          for (auto alias : resource.aliases) {
+            previous = m_images[alias].tracker->accesses();
+            if (!previous.empty()) {
+              barriers.global(
+                  {static_cast<uint32_t>(previous.size()),
+                   previous.data(),
+                   1,
+                   &access.access});
+            }
+          }
+        }
+        resource.tracker->access(
+            barriers,
+            access.access,
+            THSVS_IMAGE_LAYOUT_OPTIMAL,
+            discardContents);
+      }
+      barriers.flush();
+
+      auto& compiled = m_compiledPasses[i];
+      if (compiled.renderPassPtr) {
+        VkRenderPassBeginInfo beginInfo = {
+            VK_STRUCTURE_TYPE_RENDER_PASS_BEGIN_INFO};
+        beginInfo.renderPass = *compiled.renderPassPtr;
+        beginInfo.framebuffer = *compiled.framebufferPtr;
+        beginInfo.renderArea.extent = compiled.extent;
+        auto& clearValues = compiled.clearValues;
+        beginInfo.clearValueCount =
+            static_cast<uint32_t>(clearValues.size());
+        beginInfo.pClearValues = clearValues.data();
+        vkCmdBeginRenderPass(
+            commandBuffer,
+            &beginInfo,
+            VK_SUBPASS_CONTENTS_INLINE);
+      }
+      if (pass.recorder()) {
+        pass.recorder()(commandBuffer);
+      }
+      if (compiled.renderPassPtr) {
+        vkCmdEndRenderPass(commandBuffer);
+      }
+    }
+
+    for (auto& resource : m_images) {
+      if (resource.output && resource.tracker) {
+        resource.tracker->access(
+            barriers, resource.finalAccess);
+      }
+    }
+    barriers.flush();
+  }
+
+  // Indices of the kept passes in execution order.
+  const std::vector<uint32_t>& pass_order() const {
+    return m_order;
+  }
+
+  // Valid once plan() or compile() ran.
+  bool culled(uint32_t pass) const {
+    Expects(pass < m_kept.size());
+    return !m_kept[pass];
+  }
+
+  VkImage image_handle(graph_resource resource) const {
+    return m_images[resource].imageHandle;
+  }
+
+  VkImageView view(graph_resource resource) const {
+    return m_images[resource].view;
+  }
+
+  // Bytes allocated for transient images, and what they
+  // would take without aliasing.
+  VkDeviceSize transient_memory() const noexcept {
+    return m_transientMemory;
+  }
+
+  VkDeviceSize unaliased_memory() const noexcept {
+    return m_unaliasedMemory;
+  }
+
+private:
+  struct graph_image {
+    tl::optional<image_builder> builder = {};
+    std::unique_ptr<image> ownedImage = {};
+    std::unique_ptr<image_view> ownedView = {};
+    VkImage imageHandle = {};
+    VkImageView view = {};
+    VkFormat format = {};
+    VkExtent2D extent = {};
+    VkImageAspectFlags aspectMask = {};
+    VkSampleCountFlagBits samples = VK_SAMPLE_COUNT_1_BIT;
+    ThsvsAccessType currentAccess = THSVS_ACCESS_NONE;
+    bool output = {};
+    ThsvsAccessType finalAccess = THSVS_ACCESS_NONE;
+    bool used = {};
+    uint32_t first = {};
+    uint32_t last = {};
+    std::vector<graph_resource> aliases = {};
+    std::unique_ptr<image_tracker> tracker = {};
+
+    bool imported() const noexcept { return !builder; }
+  };
+
+  struct compiled_pass {
+    std::unique_ptr<render_pass> renderPassPtr = {};
+    std::unique_ptr<framebuffer> framebufferPtr = {};
+    VkExtent2D extent = {};
+    std::vector<VkClearValue> clearValues = {};
+  };
+
+  static void add_usage(
+      image_builder& builder,
+      ThsvsAccessType access) {
+    auto layout =
+        image_layout(access, THSVS_IMAGE_LAYOUT_OPTIMAL);
+    switch (layout) {
+      case VK_IMAGE_LAYOUT_COLOR_ATTACHMENT_OPTIMAL:
+        builder.color_attachment();
+        break;
+      case VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL:
+      case VK_IMAGE_LAYOUT_DEPTH_STENCIL_READ_ONLY_OPTIMAL:
+        builder.depth_attachment();
+        break;
+      case VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL:
+        builder.sampled();
+        break;
+      case VK_IMAGE_LAYOUT_TRANSFER_SRC_OPTIMAL:
+        builder.transfer_source();
+        break;
+      case VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL:
+        builder.transfer_destination();
+        break;
+      case VK_IMAGE_LAYOUT_GENERAL:
+        builder.storage();
+        break;
+      default:
+        break;
+    }
+  }
+
+  tl::expected<void, VkResult> create_images(
+      VkDevice device,
+      VmaAllocator allocator) {
+    for (auto& access : all_accesses()) {
+      auto& resource = m_images[access.resource];
+      if (!resource.imported()) {
+        add_usage(*resource.builder, access.access);
+      }
+    }
+    for (auto& resource : m_images) {
+      if (resource.output && !resource.imported()) {
+        add_usage(*resource.builder, resource.finalAccess);
+      }
+    }
+
+    // transient images grouped by the memory types they
+    // can live in, one allocation per group
+    std::map<uint32_t, std::vector<graph_resource>> groups;
+    std::vector<VkMemoryRequirements> requirements(
+        m_images.size());
+    for (graph_resource resource = {};
+         resource < m_images.size();
+         ++resource) {
+      auto& graphImage = m_images[resource];
+      if (!graphImage.used || graphImage.imported()) {
+        continue;
+      }
+      auto imageResult = graphImage.builder->build_unbound(
+          device, allocator);
+      if (!imageResult) {
+        return tl::make_unexpected(imageResult.error());
+      }
+      graphImage.ownedImage = std::move(*imageResult);
+      auto& ownedImage = *graphImage.ownedImage;
+      graphImage.imageHandle = ownedImage;
+      graphImage.format = ownedImage.image_format();
+      graphImage.extent = {ownedImage.extent().width,
+                           ownedImage.extent().height};
+      graphImage.aspectMask =
+          static_cast<VkImageAspectFlags>(
+              ownedImage.get_image_aspect());
+      graphImage.samples = ownedImage.samples();
+      vkGetImageMemoryRequirements(
+          device, ownedImage, &requirements[resource]);
+      groups[requirements[resource].memoryTypeBits]
+          .push_back(resource);
+    }
+
+    for (auto& group : groups) {
+      auto result = allocate_group(
+          device,
+          allocator,
+          group.first,
+          group.second,
+          requirements);
+      if (!result) {
+        return result;
+      }
+    }
+
+    for (auto& graphImage : m_images) {
+      if (!graphImage.used) {
+        continue;
+      }
+      if (!graphImage.imported()) {
+        auto viewResult =
+            image_view_builder{}
+                .from_image(*graphImage.ownedImage)
+                .build(device);
+        if (!viewResult) {
+          return tl::make_unexpected(viewResult.error());
+        }
+        graphImage.ownedView = std::move(*viewResult);
+        graphImage.view = *graphImage.ownedView;
+      }
+      graphImage.tracker = std::make_unique<image_tracker>(
+          graphImage.imageHandle,
+          graphImage.aspectMask,
+          graphImage.ownedImage
+              ? graphImage.ownedImage->mip_levels()
+              : 1,
+          graphImage.ownedImage
+              ? graphImage.ownedImage->array_layers()
+              : 1);
+      graphImage.tracker->assume(graphImage.currentAccess);
+    }
+    return {};
+  }
+
+  tl::expected<void, VkResult> allocate_group(
+      VkDevice device,
+      VmaAllocator allocator,
+      uint32_t memoryTypeBits,
+      const std::vector<graph_resource>& members,
+      const std::vector<VkMemoryRequirements>&
+          requirements) {
+    std::vector<alias_block> blocks = {};
+    VkMemoryRequirements groupRequirements = {};
+    groupRequirements.memoryTypeBits = memoryTypeBits;
+    groupRequirements.alignment = 1;
+    for (auto resource : members) {
+      auto& imageRequirements = requirements[resource];
+      blocks.push_back(
+          {imageRequirements.size,
+           imageRequirements.alignment,
+           m_images[resource].first,
+           m_images[resource].last});
+      groupRequirements.alignment = std::max(
+          groupRequirements.alignment,
+          imageRequirements.alignment);
+      m_unaliasedMemory += imageRequirements.size;
+    }
+    auto offsets =
+        place_aliased(blocks, groupRequirements.size);
+
+    VmaAllocationCreateInfo allocationCreateInfo = {};
+    allocationCreateInfo.usage = VMA_MEMORY_USAGE_GPU_ONLY;
+    VmaAllocation allocation = {};
+    VmaAllocationInfo allocationInfo = {};
+    auto allocateResult = vmaAllocateMemory(
+        allocator,
+        &groupRequirements,
+        &allocationCreateInfo,
+        &allocation,
+        &allocationInfo);
+    if (allocateResult != VK_SUCCESS) {
+      return tl::make_unexpected(allocateResult);
+    }
+    m_allocations.push_back(allocation);
+    m_transientMemory += groupRequirements.size;
+
+    for (size_t i = {}; i < members.size(); ++i) {
+      auto bindResult = vkBindImageMemory(
+          device,
+          m_images[members[i]].imageHandle,
+          allocationInfo.deviceMemory,
+          allocationInfo.offset + offsets[i]);
+      if (bindResult != VK_SUCCESS) {
+        return tl::make_unexpected(bindResult);
+      }
+      auto& aliases = m_images[members[i]].aliases;
+      for (size_t j = {}; j < members.size(); ++j) {
+        if (i != j &&
+            offsets[i] < offsets[j] + blocks[j].size &&
+            offsets[j] < offsets[i] + blocks[i].size) {
+          aliases.push_back(members[j]);
+        }
+      }
+    }
+    return {};
+  }
+
+  tl::expected<void, VkResult> create_render_passes(
+      VkDevice device) {
+    m_compiledPasses.resize(m_order.size());
+    for (uint32_t i = {}; i < m_order.size(); ++i) {
+      render_pass_builder renderPassBuilder = {};
+      subpass_builder subpassBuilder = {};
+      std::vector<VkImageView> views = {};
+      auto& compiled = m_compiledPasses[i];
+      for (auto& access : m_passes[m_order[i]].accesses()) {
+        if (!access.attachment) {
+          continue;
+        }
+        auto& resource = m_images[access.resource];
+        auto layout = image_layout(
+            access.access, THSVS_IMAGE_LAYOUT_OPTIMAL);
+        // contents nothing reads later are not stored
+        auto storeOp = VK_ATTACHMENT_STORE_OP_DONT_CARE;
+        if (resource.imported() || resource.output ||
+            resource.last > i) {
+          storeOp = VK_ATTACHMENT_STORE_OP_STORE;
+        }
+        auto index = static_cast<uint32_t>(views.size());
+        renderPassBuilder.add_attachment(
+            attachment_builder{}
+                .format(resource.format)
+                .samples(resource.samples)
+                .loadOp(access.loadOp)
+                .storeOp(storeOp)
+                .stencilLoadOp(access.loadOp)
+                .stencilStoreOp(storeOp)
+                .initial_layout(layout)
+                .final_layout(layout)
+                .build());
+        if (access.access ==
+            THSVS_ACCESS_DEPTH_STENCIL_ATTACHMENT_WRITE) {
+          subpassBuilder.depth_attachment(index, layout);
+        } else {
+          subpassBuilder.color_attachment(index, layout);
+        }
+        views.push_back(resource.view);
+        compiled.extent = resource.extent;
+        compiled.clearValues.push_back(access.clearValue);
+      }
+      if (views.empty()) {
+        continue;
+      }
+
+      auto mainSubpass = subpassBuilder.build();
+      auto renderPassResult =
+          renderPassBuilder.add_subpass(mainSubpass)
+              .build(device);
+      if (!renderPassResult) {
+        return tl::make_unexpected(
+            renderPassResult.error());
+      }
+      compiled.renderPassPtr = std::move(*renderPassResult);
+
+      auto framebufferResult =
+          framebuffer_builder{}
+              .render_pass(*compiled.renderPassPtr)
+              .dimensions(
+                  compiled.extent.width,
+                  compiled.extent.height)
+              .attachments(std::move(views))
+              .build(device);
+      if (!framebufferResult) {
+        return tl::make_unexpected(
+            framebufferResult.error());
+      }
+      compiled.framebufferPtr =
+          std::move(*framebufferResult);
+    }
+    return {};
+  }
+
+  std::vector<graph_access> all_accesses() const {
+    std::vector<graph_access> accesses = {};
+    for (auto pass : m_order) {
+      auto& passAccesses = m_passes[pass].accesses();
+      accesses.insert(
+          accesses.end(),
+          passAccesses.begin(),
+          passAccesses.end());
+    }
+    return accesses;
+  }
+
+  // Images and views go before the memory they are bound
+  // to.
+  void release() noexcept {
+    m_compiledPasses.clear();
+    for (auto& graphImage : m_images) {
+      graphImage.tracker.reset();
+      graphImage.aliases.clear();
+      if (graphImage.imported()) {
+        continue;
+      }
+      graphImage.ownedView.reset();
+      graphImage.ownedImage.reset();
+      graphImage.imageHandle = {};
+      graphImage.view = {};
+    }
+    for (auto allocation : m_allocations) {
+      vmaFreeMemory(m_allocator, allocation);
+    }
+    m_allocations.clear();
+    m_transientMemory = {};
+    m_unaliasedMemory = {};
+  }
+
+  VmaAllocator m_allocator = {};
+  std::vector<graph_image> m_images = {};
+  std::vector<graph_pass> m_passes = {};
+  std::vector<bool> m_kept = {};
+  std::vector<uint32_t> m_order = {};
+  std::vector<compiled_pass> m_compiledPasses = {};
+  std::vector<VmaAllocation> m_allocations = {};
+  VkDeviceSize m_transientMemory = {};
+  VkDeviceSize m_unaliasedMemory = {};
+};
+}  // namespace vka
@@ -0,0 +1,154 @@
+#include "render_graph.hpp"
+
+#include <catch2/catch.hpp>
+#include "command_buffer.hpp"
+#include "command_pool.hpp"
+#include "device.hpp"
+#include "instance.hpp"
+#include "memory_allocator.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue_family.hpp"
+
+using namespace vka;
+TEST_CASE("Aliased blocks only share memory when apart") {
+  VkDeviceSize totalSize = {};
+  auto offsets = place_aliased(
+      {{100, 1, 0, 1}, {100, 1, 2, 3}, {50, 64, 1, 3}},
+      totalSize);
+  REQUIRE(offsets[0] == 0);
+  REQUIRE(offsets[1] == 0);
+  REQUIRE(offsets[2] == 128);
+  REQUIRE(totalSize == 178);
+}
+
+TEST_CASE("Render graph culls and orders passes") {
+  render_graph graph = {};
+  auto first = graph.create_image(image_builder{});
+  auto second = graph.create_image(image_builder{});
+  auto combined = graph.create_image(image_builder{});
+  auto unused = graph.create_image(image_builder{});
+  auto target = graph.create_image(image_builder{});
+  graph.output(target, THSVS_ACCESS_TRANSFER_READ);
+
+  auto clear = VK_ATTACHMENT_LOAD_OP_CLEAR;
+  auto drawFirst =
+      graph.add_pass(graph_pass{}.color(first, clear));
+  auto drawSecond =
+      graph.add_pass(graph_pass{}.color(second, clear));
+  auto debug = graph.add_pass(
+      graph_pass{}.sampled(first).color(unused));
+  auto combine = graph.add_pass(
+      graph_pass{}.sampled(first).color(combined));
+  auto present = graph.add_pass(graph_pass{}
+                                    .sampled(second)
+                                    .sampled(combined)
+                                    .color(target));
+  graph.plan();
+
+  REQUIRE(graph.culled(debug));
+  // combine runs as soon as first is ready, so first is
+  // done before second is drawn
+  REQUIRE(
+      graph.pass_order() ==
+      std::vector<uint32_t>{
+          drawFirst, combine, drawSecond, present});
+}
+
+TEST_CASE("Render graph records passes with barriers") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  render_graph graph = {};
+  auto transient = [&] {
+    return image_builder{}
+        .gpu_only()
+        .format(VK_FORMAT_R8G8B8A8_UNORM)
+        .image_extent(64, 64)
+        .type_2d()
+        .queue_family_index(queueFamily.familyIndex);
+  };
+  auto first = graph.create_image(transient());
+  auto second = graph.create_image(transient());
+  auto target = graph.create_image(transient());
+  graph.output(target, THSVS_ACCESS_TRANSFER_READ);
+
+  uint32_t recorded = {};
+  graph.add_pass(graph_pass{}
+                     .color(
+                         first, VK_ATTACHMENT_LOAD_OP_CLEAR)
+                     .record([&](auto) { ++recorded; }));
+  graph.add_pass(graph_pass{}
+                     .sampled(first)
+                     .color(second)
+                     .record([&](auto) { ++recorded; }));
+  graph.add_pass(graph_pass{}
+                     .sampled(second)
+                     .color(target)
+                     .record([&](auto) { ++recorded; }));
+  REQUIRE(graph.compile(*devicePtr, *allocatorPtr));
+  // first and target never live at the same time
+  REQUIRE(
+      graph.transient_memory() < graph.unaliased_memory());
+
+  std::unique_ptr<command_pool> commandPoolPtr = {};
+  command_pool_builder{}
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*devicePtr)
+      .map(move_into{commandPoolPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<command_buffer> commandPtr = {};
+  command_buffer_allocator{}
+      .set_command_pool(commandPoolPtr.get())
+      .allocate(*devicePtr)
+      .map(move_into{commandPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkCommandBufferBeginInfo beginInfo = {
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+  REQUIRE(
+      vkBeginCommandBuffer(*commandPtr, &beginInfo) ==
+      VK_SUCCESS);
+
+  graph.execute(*commandPtr);
+  graph.execute(*commandPtr);
+  REQUIRE(recorded == 6);
+  REQUIRE(vkEndCommandBuffer(*commandPtr) == VK_SUCCESS);
+}
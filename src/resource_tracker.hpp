@@ -0,0 +1,466 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <cstdint>
+#include <iterator>
+#include <map>
+#include <vector>
+#include "barrier_batcher.hpp"
+#include "buffer.hpp"
+#include "image.hpp"
+#include "sync_helper.hpp"
+
+namespace vka {
+static_assert(
+    THSVS_ACCESS_PRESENT < 64,
+    "read accesses must fit in resource_state::reads");
+
+inline bool is_write_access(ThsvsAccessType access) {
+  return access > THSVS_ACCESS_PRESENT;
+}
+
+inline VkImageLayout image_layout(
+    ThsvsAccessType access,
+    ThsvsImageLayout layout) {
+  ThsvsImageBarrier barrier = {};
+  barrier.nextAccessCount = 1;
+  barrier.pNextAccesses = &access;
+  barrier.nextLayout = layout;
+  VkPipelineStageFlags srcStages = {};
+  VkPipelineStageFlags dstStages = {};
+  VkImageMemoryBarrier imageBarrier = {};
+  thsvsGetVulkanImageMemoryBarrier(
+      barrier, &srcStages, &dstStages, &imageBarrier);
+  return imageBarrier.newLayout;
+}
+
+// How a buffer range or image subresource was last
+// accessed: the last write, and a bit per read access made
+// since that write or since the last layout transition.
+struct resource_state {
+  ThsvsAccessType lastWrite = THSVS_ACCESS_NONE;
+  uint64_t reads = {};
+  ThsvsImageLayout layout = THSVS_IMAGE_LAYOUT_OPTIMAL;
+  bool transitioned = {};
+
+  bool read(ThsvsAccessType access) const noexcept {
+    return (reads & (uint64_t(1) << access)) != 0;
+  }
+
+  // The accesses a barrier has to wait on before the
+  // next one: the reads if there were any, else the write.
+  std::vector<ThsvsAccessType> accesses() const {
+    std::vector<ThsvsAccessType> result = {};
+    for (uint32_t i = {}; i <= THSVS_ACCESS_PRESENT; ++i) {
+      if (read(static_cast<ThsvsAccessType>(i))) {
+        result.push_back(static_cast<ThsvsAccessType>(i));
+      }
+    }
+    if (result.empty() &&
+        lastWrite != THSVS_ACCESS_NONE) {
+      result.push_back(lastWrite);
+    }
+    return result;
+  }
+
+  // VK_IMAGE_LAYOUT_UNDEFINED before the first access.
+  VkImageLayout image_layout() const {
+    auto previous = accesses();
+    if (previous.empty()) {
+      return VK_IMAGE_LAYOUT_UNDEFINED;
+    }
+    return vka::image_layout(previous.front(), layout);
+  }
+
+  bool operator==(const resource_state& other) const {
+    return lastWrite == other.lastWrite &&
+           reads == other.reads && layout == other.layout &&
+           transitioned == other.transitioned;
+  }
+
+  bool operator!=(const resource_state& other) const {
+    return !(*this == other);
+  }
+};
+
+// Moves state to the next access. Returns true if a barrier
+// is needed first, with the accesses it waits on in
+// previous. Reads after a write only wait on the write,
+// and a read already made since then needs nothing.
+inline bool advance_state(
+    resource_state& state,
+    ThsvsAccessType next,
+    ThsvsImageLayout layout,
+    bool layoutChanges,
+    std::vector<ThsvsAccessType>& previous) {
+  previous = state.accesses();
+  if (is_write_access(next)) {
+    state = {next, {}, layout, {}};
+    return layoutChanges || !previous.empty();
+  }
+
+  auto readBit = uint64_t(1) << next;
+  if (layoutChanges) {
+    state = {THSVS_ACCESS_NONE, readBit, layout, true};
+    return true;
+  }
+  if (state.read(next)) {
+    return false;
+  }
+  state.reads |= readBit;
+  if (state.lastWrite != THSVS_ACCESS_NONE) {
+    previous.assign(1, state.lastWrite);
+    return true;
+  }
+  // reads of memory nothing has written need no barrier,
+  // unless they have to follow a layout transition
+  return state.transitioned;
+}
+
+// Tracks every mip level and array layer of one image and
+// records into a barrier_batcher the barrier each newly
+// declared access needs. Subresources in the same state
+// share one barrier.
+struct image_tracker {
+  explicit image_tracker(
+      VkImage imageHandle,
+      VkImageAspectFlags aspectMask,
+      uint32_t mipLevels,
+      uint32_t arrayLayers)
+      : m_image(imageHandle),
+        m_aspectMask(aspectMask),
+        m_mipLevels(mipLevels),
+        m_arrayLayers(arrayLayers),
+        m_states(mipLevels * arrayLayers) {}
+
+  explicit image_tracker(const image& trackedImage)
+      : image_tracker(
+            trackedImage,
+            static_cast<VkImageAspectFlags>(
+                trackedImage.get_image_aspect()),
+            trackedImage.mip_levels(),
+            trackedImage.array_layers()) {}
+
+  // Declares that the next commands access range as next.
+  // With discardContents the contents before this access
+  // need not be kept.
+  void access(
+      barrier_batcher& barriers,
+      ThsvsAccessType next,
+      VkImageSubresourceRange range,
+      ThsvsImageLayout layout = THSVS_IMAGE_LAYOUT_OPTIMAL,
+      bool discardContents = {}) {
+    if (range.levelCount == VK_REMAINING_MIP_LEVELS) {
+      range.levelCount = m_mipLevels - range.baseMipLevel;
+    }
+    if (range.layerCount == VK_REMAINING_ARRAY_LAYERS) {
+      range.layerCount =
+          m_arrayLayers - range.baseArrayLayer;
+    }
+    range.aspectMask = m_aspectMask;
+
+    auto& first =
+        state_at(range.baseMipLevel, range.baseArrayLayer);
+    auto uniform = true;
+    for_each(range, [&](uint32_t mip, uint32_t layer) {
+      uniform = uniform && state_at(mip, layer) == first;
+    });
+    if (uniform) {
+      auto previousState = first;
+      auto nextState = first;
+      auto needed = advance(
+          nextState, next, layout, discardContents);
+      for_each(range, [&](uint32_t mip, uint32_t layer) {
+        state_at(mip, layer) = nextState;
+      });
+      if (needed) {
+        record(
+            barriers,
+            previousState,
+            next,
+            layout,
+            discardContents,
+            range);
+      }
+      return;
+    }
+
+    for_each(range, [&](uint32_t mip, uint32_t layer) {
+      auto& current = state_at(mip, layer);
+      auto previousState = current;
+      if (advance(current, next, layout, discardContents)) {
+        record(
+            barriers,
+            previousState,
+            next,
+            layout,
+            discardContents,
+            {m_aspectMask, mip, 1, layer, 1});
+      }
+    });
+  }
+
+  void access(
+      barrier_batcher& barriers,
+      ThsvsAccessType next,
+      ThsvsImageLayout layout = THSVS_IMAGE_LAYOUT_OPTIMAL,
+      bool discardContents = {}) {
+    access(
+        barriers,
+        next,
+        {m_aspectMask,
+         0,
+         VK_REMAINING_MIP_LEVELS,
+         0,
+         VK_REMAINING_ARRAY_LAYERS},
+        layout,
+        discardContents);
+  }
+
+  // Takes access as the last one to every subresource,
+  // for images whose earlier accesses were not tracked.
+  void assume(
+      ThsvsAccessType access,
+      ThsvsImageLayout layout =
+          THSVS_IMAGE_LAYOUT_OPTIMAL) {
+    resource_state assumed = {};
+    assumed.layout = layout;
+    if (is_write_access(access)) {
+      assumed.lastWrite = access;
+    } else if (access != THSVS_ACCESS_NONE) {
+      assumed.reads = uint64_t(1) << access;
+      assumed.transitioned = true;
+    }
+    std::fill(m_states.begin(), m_states.end(), assumed);
+  }
+
+  const resource_state& state(
+      uint32_t mipLevel,
+      uint32_t arrayLayer) const {
+    return m_states[arrayLayer * m_mipLevels + mipLevel];
+  }
+
+  // The accesses of every subresource, without duplicates.
+  std::vector<ThsvsAccessType> accesses() const {
+    std::vector<ThsvsAccessType> result = {};
+    for (auto& current : m_states) {
+      for (auto access : current.accesses()) {
+        if (std::find(
+                result.begin(), result.end(), access) ==
+            result.end()) {
+          result.push_back(access);
+        }
+      }
+    }
+    return result;
+  }
+
+  operator VkImage() const noexcept { return m_image; }
+
+private:
+  resource_state& state_at(
+      uint32_t mipLevel,
+      uint32_t arrayLayer) {
+    return m_states[arrayLayer * m_mipLevels + mipLevel];
+  }
+
+  template <typename F>
+  static void for_each(
+      const VkImageSubresourceRange& range,
+      F function) {
+    for (auto layer = range.baseArrayLayer;
+         layer < range.baseArrayLayer + range.layerCount;
+         ++layer) {
+      for (auto mip = range.baseMipLevel;
+           mip < range.baseMipLevel + range.levelCount;
+           ++mip) {
+        function(mip, layer);
+      }
+    }
+  }
+
+  bool advance(
+      resource_state& current,
+      ThsvsAccessType next,
+      ThsvsImageLayout layout,
+      bool discardContents) {
+    auto layoutChanges =
+        discardContents ||
+        current.image_layout() !=
+            image_layout(next, layout);
+    return advance_state(
+        current, next, layout, layoutChanges, m_previous);
+  }
+
+  void record(
+      barrier_batcher& barriers,
+      const resource_state& previousState,
+      ThsvsAccessType next,
+      ThsvsImageLayout layout,
+      bool discardContents,
+      VkImageSubresourceRange range) {
+    ThsvsImageBarrier barrier = {};
+    barrier.prevAccessCount =
+        static_cast<uint32_t>(m_previous.size());
+    barrier.pPrevAccesses = m_previous.data();
+    barrier.nextAccessCount = 1;
+    barrier.pNextAccesses = &next;
+    barrier.prevLayout = previousState.layout;
+    barrier.nextLayout = layout;
+    barrier.discardContents =
+        discardContents || m_previous.empty() ? VK_TRUE
+                                              : VK_FALSE;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.image = m_image;
+    barrier.subresourceRange = range;
+    barriers.image(barrier);
+  }
+
+  VkImage m_image = {};
+  VkImageAspectFlags m_aspectMask = {};
+  uint32_t m_mipLevels = {};
+  uint32_t m_arrayLayers = {};
+  std::vector<resource_state> m_states = {};
+  std::vector<ThsvsAccessType> m_previous = {};
+};
+
+// Tracks byte ranges of one buffer, splitting and merging
+// them as accesses are declared, and records the barriers
+// they need into a barrier_batcher.
+struct buffer_tracker {
+  explicit buffer_tracker(
+      VkBuffer bufferHandle,
+      VkDeviceSize bufferSize)
+      : m_buffer(bufferHandle), m_size(bufferSize) {
+    m_segments[0] = {bufferSize, {}};
+  }
+
+  explicit buffer_tracker(buffer& trackedBuffer)
+      : buffer_tracker(
+            trackedBuffer,
+            trackedBuffer.size()) {}
+
+  void access(
+      barrier_batcher& barriers,
+      ThsvsAccessType next,
+      VkDeviceSize offset = 0,
+      VkDeviceSize size = VK_WHOLE_SIZE) {
+    auto end =
+        size == VK_WHOLE_SIZE ? m_size : offset + size;
+    split(offset);
+    split(end);
+    auto first = m_segments.find(offset);
+    auto last = m_segments.lower_bound(end);
+
+    auto uniform = true;
+    for (auto it = first; it != last; ++it) {
+      uniform = uniform && it->second.state ==
+                               first->second.state;
+    }
+    if (uniform) {
+      if (advance_state(
+              first->second.state,
+              next,
+              {},
+              {},
+              m_previous)) {
+        record(barriers, next, offset, end);
+      }
+      for (auto it = std::next(first); it != last; ++it) {
+        it->second.state = first->second.state;
+      }
+    } else {
+      for (auto it = first; it != last; ++it) {
+        if (advance_state(
+                it->second.state,
+                next,
+                {},
+                {},
+                m_previous)) {
+          record(
+              barriers, next, it->first, it->second.end);
+        }
+      }
+    }
+    merge(offset, end);
+  }
+
+  // The state of the range containing offset.
+  const resource_state& state(VkDeviceSize offset) const {
+    return std::prev(m_segments.upper_bound(offset))
+        ->second.state;
+  }
+
+  // Number of ranges with distinct state.
+  size_t range_count() const noexcept {
+    return m_segments.size();
+  }
+
+  operator VkBuffer() const noexcept { return m_buffer; }
+
+private:
+  struct segment {
+    VkDeviceSize end = {};
+    resource_state state = {};
+  };
+
+  void split(VkDeviceSize offset) {
+    if (offset >= m_size) {
+      return;
+    }
+    auto it = std::prev(m_segments.upper_bound(offset));
+    if (it->first == offset) {
+      return;
+    }
+    m_segments[offset] = {it->second.end, it->second.state};
+    it->second.end = offset;
+  }
+
+  // Joins neighbors left with equal state by an access
+  // covering offset to end.
+  void merge(VkDeviceSize offset, VkDeviceSize end) {
+    auto it = std::prev(m_segments.upper_bound(offset));
+    if (it != m_segments.begin()) {
+      --it;
+    }
+    while (it != m_segments.end() && it->first <= end) {
+      auto nextIt = std::next(it);
+      if (nextIt == m_segments.end()) {
+        break;
+      }
+      if (nextIt->second.state == it->second.state) {
+        it->second.end = nextIt->second.end;
+        m_segments.erase(nextIt);
+      } else {
+        it = nextIt;
+      }
+    }
+  }
+
+  void record(
+      barrier_batcher& barriers,
+      ThsvsAccessType next,
+      VkDeviceSize offset,
+      VkDeviceSize end) {
+    ThsvsBufferBarrier barrier = {};
+    barrier.prevAccessCount =
+        static_cast<uint32_t>(m_previous.size());
+    barrier.pPrevAccesses = m_previous.data();
+    barrier.nextAccessCount = 1;
+    barrier.pNextAccesses = &next;
+    barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+    barrier.buffer = m_buffer;
+    barrier.offset = offset;
+    barrier.size = end - offset;
+    barriers.buffer(barrier);
+  }
+
+  VkBuffer m_buffer = {};
+  VkDeviceSize m_size = {};
+  std::map<VkDeviceSize, segment> m_segments = {};
+  std::vector<ThsvsAccessType> m_previous = {};
+};
+}  // namespace vka
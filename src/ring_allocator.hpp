@@ -0,0 +1,284 @@
+#pragma once
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <tl/expected.hpp>
+#include <tl/optional.hpp>
+#include "buffer.hpp"
+#include "gsl-lite.hpp"
+
+namespace vka {
+inline VkDeviceSize align_up(
+    VkDeviceSize value,
+    VkDeviceSize alignment) noexcept {
+  if (alignment == 0) {
+    return value;
+  }
+  return (value + alignment - 1) / alignment * alignment;
+}
+
+// Bookkeeping for a linear ring of bytes. Allocations are
+// handed out in order and released in the same order,
+// one frame mark at a time. Once everything is released the
+// ring starts over at offset 0; marks taken before that
+// cover nothing live and are ignored by release().
+struct ring_range {
+  struct mark {
+    VkDeviceSize head = {};
+    VkDeviceSize allocatedTotal = {};
+    uint64_t generation = {};
+  };
+
+  explicit ring_range(VkDeviceSize capacity)
+      : m_capacity(capacity) {}
+
+  tl::optional<VkDeviceSize> allocate(
+      VkDeviceSize size,
+      VkDeviceSize alignment) noexcept {
+    if (size == 0 || size > m_capacity) {
+      return {};
+    }
+    if (used() == 0 && m_head != 0) {
+      m_head = 0;
+      m_tail = 0;
+      ++m_generation;
+    }
+    auto offset = align_up(m_head, alignment);
+    if (used() == 0 || m_head > m_tail) {
+      if (offset + size <= m_capacity) {
+        return commit(offset, size);
+      }
+      // wrap to the front, wasting the tail end
+      if (used() != 0 && size > m_tail) {
+        return {};
+      }
+      m_allocatedTotal += m_capacity - m_head;
+      m_head = 0;
+      return commit(0, size);
+    }
+    if (offset + size <= m_tail) {
+      return commit(offset, size);
+    }
+    return {};
+  }
+
+  mark get_mark() const noexcept {
+    return {m_head, m_allocatedTotal, m_generation};
+  }
+
+  void release(mark frameMark) noexcept {
+    if (frameMark.generation != m_generation) {
+      return;
+    }
+    m_tail = frameMark.head;
+    m_releasedTotal = frameMark.allocatedTotal;
+  }
+
+  VkDeviceSize used() const noexcept {
+    return m_allocatedTotal - m_releasedTotal;
+  }
+
+  VkDeviceSize capacity() const noexcept {
+    return m_capacity;
+  }
+
+private:
+  VkDeviceSize commit(
+      VkDeviceSize offset,
+      VkDeviceSize size) noexcept {
+    m_allocatedTotal += offset + size - m_head;
+    m_head = offset + size;
+    return offset;
+  }
+
+  VkDeviceSize m_capacity = {};
+  VkDeviceSize m_head = {};
+  VkDeviceSize m_tail = {};
+  VkDeviceSize m_allocatedTotal = {};
+  VkDeviceSize m_releasedTotal = {};
+  uint64_t m_generation = {};
+};
+
+struct ring_allocation {
+  VkBuffer buffer = {};
+  VkDeviceSize offset = {};
+  VkDeviceSize size = {};
+  void* data = {};
+};
+
+struct ring_out_of_space {};
+
+struct ring_allocator {
+  explicit ring_allocator(
+      VkDevice device,
+      std::unique_ptr<buffer> bufferPtr,
+      void* mapPtr,
+      VkDeviceSize capacity,
+      VkDeviceSize minAlignment)
+      : m_device(device),
+        m_buffer(std::move(bufferPtr)),
+        m_mapPtr(static_cast<char*>(mapPtr)),
+        m_range(capacity),
+        m_minAlignment(minAlignment) {}
+
+  ring_allocator(const ring_allocator&) = delete;
+  ring_allocator(ring_allocator&&) = default;
+  ring_allocator& operator=(const ring_allocator&) = delete;
+  ring_allocator& operator=(ring_allocator&&) = default;
+
+  operator VkBuffer() { return *m_buffer; }
+
+  tl::expected<ring_allocation, ring_out_of_space> allocate(
+      VkDeviceSize size,
+      VkDeviceSize alignment = 1) noexcept {
+    auto offset = m_range.allocate(
+        size, std::max(alignment, m_minAlignment));
+    if (!offset) {
+      return tl::make_unexpected(ring_out_of_space{});
+    }
+    return ring_allocation{
+        *m_buffer, *offset, size, m_mapPtr + *offset};
+  }
+
+  template <typename T>
+  tl::expected<ring_allocation, ring_out_of_space> push(
+      gsl::span<T> data,
+      VkDeviceSize alignment = alignof(T)) noexcept {
+    auto byteCount =
+        static_cast<VkDeviceSize>(data.length_bytes());
+    return allocate(byteCount, alignment)
+        .map([&](ring_allocation allocation) {
+          std::memcpy(
+              allocation.data, data.data(), byteCount);
+          return allocation;
+        });
+  }
+
+  // Closes the current frame. Its allocations are reclaimed
+  // by a later reclaim() once frameFence has signaled.
+  void end_frame(VkFence frameFence) {
+    m_buffer->flush();
+    m_pending.push_back({frameFence, m_range.get_mark()});
+  }
+
+  // Releases the regions of all retired frames whose fences
+  // have signaled, oldest first.
+  void reclaim() {
+    while (!m_pending.empty()) {
+      auto& oldest = m_pending.front();
+      if (vkGetFenceStatus(m_device, oldest.fence) !=
+          VK_SUCCESS) {
+        break;
+      }
+      m_range.release(oldest.frameMark);
+      m_pending.pop_front();
+    }
+  }
+
+  VkDeviceSize used() const noexcept {
+    return m_range.used();
+  }
+
+  VkDeviceSize capacity() const noexcept {
+    return m_range.capacity();
+  }
+
+private:
+  struct retired_frame {
+    VkFence fence = {};
+    ring_range::mark frameMark = {};
+  };
+
+  VkDevice m_device = {};
+  std::unique_ptr<buffer> m_buffer = {};
+  char* m_mapPtr = {};
+  ring_range m_range;
+  VkDeviceSize m_minAlignment = {};
+  std::deque<retired_frame> m_pending = {};
+};
+
+struct ring_allocator_builder {
+  tl::expected<std::unique_ptr<ring_allocator>, VkResult>
+  build(VkDevice device, VmaAllocator allocator) {
+    std::unique_ptr<buffer> bufferPtr = {};
+    auto bufferResult = m_bufferBuilder.size(m_size)
+                            .cpu_to_gpu()
+                            .persistently_mapped()
+                            .build(allocator);
+    if (!bufferResult) {
+      return tl::make_unexpected(bufferResult.error());
+    }
+    bufferPtr = std::move(*bufferResult);
+
+    auto mapResult = bufferPtr->map();
+    if (!mapResult) {
+      return tl::make_unexpected(mapResult.error());
+    }
+
+    return std::make_unique<ring_allocator>(
+        device,
+        std::move(bufferPtr),
+        *mapResult,
+        m_size,
+        m_minAlignment);
+  }
+
+  ring_allocator_builder& size(VkDeviceSize ringSize) {
+    m_size = ringSize;
+    return *this;
+  }
+
+  // Every allocation is aligned to at least this value,
+  // e.g. minUniformBufferOffsetAlignment.
+  ring_allocator_builder& min_alignment(
+      VkDeviceSize alignment) {
+    m_minAlignment = alignment;
+    return *this;
+  }
+
+  ring_allocator_builder& uniform_buffer() {
+    m_bufferBuilder.uniform_buffer();
+    return *this;
+  }
+
+  ring_allocator_builder& storage_buffer() {
+    m_bufferBuilder.storage_buffer();
+    return *this;
+  }
+
+  ring_allocator_builder& vertex_buffer() {
+    m_bufferBuilder.vertex_buffer();
+    return *this;
+  }
+
+  ring_allocator_builder& index_buffer() {
+    m_bufferBuilder.index_buffer();
+    return *this;
+  }
+
+  ring_allocator_builder& indirect_buffer() {
+    m_bufferBuilder.indirect_buffer();
+    return *this;
+  }
+
+  ring_allocator_builder& transfer_source() {
+    m_bufferBuilder.transfer_source();
+    return *this;
+  }
+
+  ring_allocator_builder& queue_family_index(
+      uint32_t index) {
+    m_bufferBuilder.queue_family_index(index);
+    return *this;
+  }
+
+private:
+  buffer_builder m_bufferBuilder = {};
+  VkDeviceSize m_size = {};
+  VkDeviceSize m_minAlignment = 1;
+};
+}  // namespace vka
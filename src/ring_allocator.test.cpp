@@ -0,0 +1,136 @@
+#include "ring_allocator.hpp"
+
+#include <array>
+#include <catch2/catch.hpp>
+#include "device.hpp"
+#include "instance.hpp"
+#include "memory_allocator.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue_family.hpp"
+
+using namespace vka;
+TEST_CASE("Ring range allocations are aligned") {
+  ring_range range{1024};
+  auto first = range.allocate(10, 1);
+  auto second = range.allocate(16, 256);
+  REQUIRE(first);
+  REQUIRE(*first == 0);
+  REQUIRE(second);
+  REQUIRE(*second == 256);
+  REQUIRE(range.used() == 272);
+}
+
+TEST_CASE("Ring range fails when full") {
+  ring_range range{256};
+  REQUIRE(range.allocate(200, 1));
+  REQUIRE(!range.allocate(100, 1));
+}
+
+TEST_CASE("Ring range reclaims a released frame") {
+  ring_range range{256};
+  REQUIRE(range.allocate(128, 1));
+  auto frame0 = range.get_mark();
+  REQUIRE(range.allocate(64, 1));
+  auto frame1 = range.get_mark();
+  REQUIRE(!range.allocate(128, 1));
+
+  range.release(frame0);
+  auto wrapped = range.allocate(128, 1);
+  REQUIRE(wrapped);
+  REQUIRE(*wrapped == 0);
+
+  range.release(frame1);
+  REQUIRE(range.used() == 128 + 64);
+}
+
+TEST_CASE(
+    "Ring range resets once every frame is released") {
+  ring_range range{256};
+  REQUIRE(range.allocate(200, 1));
+  range.release(range.get_mark());
+  REQUIRE(range.used() == 0);
+  auto offset = range.allocate(256, 1);
+  REQUIRE(offset);
+  REQUIRE(*offset == 0);
+}
+
+TEST_CASE("Ring range ignores marks from before a reset") {
+  ring_range range{64};
+  REQUIRE(range.allocate(30, 1));
+  auto frame0 = range.get_mark();
+  // an empty frame
+  auto frame1 = range.get_mark();
+
+  range.release(frame0);
+  auto second = range.allocate(50, 1);
+  REQUIRE(second);
+  REQUIRE(*second == 0);
+
+  range.release(frame1);
+  REQUIRE(range.used() == 50);
+  REQUIRE(!range.allocate(20, 1));
+  range.release(range.get_mark());
+  REQUIRE(range.used() == 0);
+}
+
+TEST_CASE("Allocate from a ring allocator") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<ring_allocator> ringPtr = {};
+  ring_allocator_builder{}
+      .size(4096)
+      .min_alignment(256)
+      .uniform_buffer()
+      .vertex_buffer()
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*devicePtr, *allocatorPtr)
+      .map(move_into{ringPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::array<float, 4> color = {1.f, 0.f, 0.f, 1.f};
+  ring_allocation allocation = {};
+  ringPtr->push(gsl::span<float>(color))
+      .map(move_into{allocation})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(allocation.buffer != VK_NULL_HANDLE);
+  REQUIRE(allocation.data != nullptr);
+  REQUIRE(ringPtr->used() == sizeof(color));
+}
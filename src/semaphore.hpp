@@ -1,7 +1,11 @@
 #pragma once
 #include <vulkan/vulkan.h>
+#include <deque>
 #include <memory>
 #include <tl/expected.hpp>
+#include <vector>
+#include "fence.hpp"
+#include "gsl-lite.hpp"
 
 namespace vka {
 struct semaphore {
@@ -46,4 +50,83 @@ struct semaphore_builder {
   }
 };
 
+// Recycles binary semaphores instead of destroying them.
+// A semaphore may only be reused once every wait on it has
+// completed, so release() takes the fence of the last
+// submission that waited on it. Not thread safe.
+struct semaphore_pool {
+  explicit semaphore_pool(VkDevice device)
+      : m_device(device) {}
+
+  semaphore_pool(const semaphore_pool&) = delete;
+  semaphore_pool(semaphore_pool&&) = default;
+  semaphore_pool& operator=(const semaphore_pool&) = delete;
+  semaphore_pool& operator=(semaphore_pool&&) = default;
+
+  // The returned semaphore is unsignaled.
+  tl::expected<std::unique_ptr<semaphore>, VkResult>
+  acquire() {
+    collect();
+    if (m_free.empty()) {
+      auto semaphoreResult =
+          semaphore_builder{}.build(m_device);
+      if (semaphoreResult) {
+        ++m_createdCount;
+      }
+      return semaphoreResult;
+    }
+    auto semaphorePtr = std::move(m_free.back());
+    m_free.pop_back();
+    return semaphorePtr;
+  }
+
+  // The semaphore must be unsignaled, or have its last wait
+  // in the submission that signals waitFence; see
+  // fence_unsignaled(). A null waitFence means the
+  // semaphore is free to reuse now.
+  void release(
+      std::unique_ptr<semaphore> semaphorePtr,
+      VkFence waitFence = VK_NULL_HANDLE) {
+    if (waitFence == VK_NULL_HANDLE) {
+      m_free.push_back(std::move(semaphorePtr));
+      return;
+    }
+    Expects(fence_unsignaled(m_device, waitFence));
+    m_parked.push_back(
+        {std::move(semaphorePtr), waitFence});
+  }
+
+  // Moves semaphores whose fences have signaled to the free
+  // list, oldest first.
+  void collect() {
+    while (!m_parked.empty()) {
+      auto& oldest = m_parked.front();
+      if (vkGetFenceStatus(m_device, oldest.waitFence) !=
+          VK_SUCCESS) {
+        break;
+      }
+      m_free.push_back(std::move(oldest.semaphorePtr));
+      m_parked.pop_front();
+    }
+  }
+
+  size_t available() const noexcept {
+    return m_free.size();
+  }
+
+  size_t created_count() const noexcept {
+    return m_createdCount;
+  }
+
+private:
+  struct parked_semaphore {
+    std::unique_ptr<semaphore> semaphorePtr = {};
+    VkFence waitFence = {};
+  };
+
+  VkDevice m_device = {};
+  std::vector<std::unique_ptr<semaphore>> m_free = {};
+  std::deque<parked_semaphore> m_parked = {};
+  size_t m_createdCount = {};
+};
 }  // namespace vka
\ No newline at end of file
@@ -2,10 +2,12 @@
 
 #include <catch2/catch.hpp>
 #include "device.hpp"
+#include "fence.hpp"
 #include "instance.hpp"
 #include "move_into.hpp"
 #include "physical_device.hpp"
 #include "platform_glfw.hpp"
+#include "queue.hpp"
 #include "queue_family.hpp"
 
 using namespace vka;
@@ -48,4 +50,81 @@ TEST_CASE("Create a semaphore") {
   REQUIRE(
       semaphorePtr->operator VkSemaphore() !=
       VK_NULL_HANDLE);
+}
+
+TEST_CASE("Semaphore pool waits for the release fence") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<fence> waitFence = {};
+  fence_builder{}
+      .build(*devicePtr)
+      .map(move_into{waitFence})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue graphicsQueue = {};
+  queue_builder{}
+      .queue_info(queueFamily, 0)
+      .build(*devicePtr)
+      .map(move_into{graphicsQueue})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  semaphore_pool pool{*devicePtr};
+  std::unique_ptr<semaphore> semaphorePtr = {};
+  pool.acquire()
+      .map(move_into{semaphorePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(pool.created_count() == 1);
+
+  pool.release(std::move(semaphorePtr), *waitFence);
+  pool.collect();
+  REQUIRE(pool.available() == 0);
+
+  VkFence fenceHandle = *waitFence;
+  REQUIRE(
+      vkQueueSubmit(
+          graphicsQueue, 0, nullptr, fenceHandle) ==
+      VK_SUCCESS);
+  REQUIRE(
+      vkWaitForFences(
+          *devicePtr,
+          1,
+          &fenceHandle,
+          VK_TRUE,
+          UINT64_MAX) == VK_SUCCESS);
+  pool.collect();
+  REQUIRE(pool.available() == 1);
+
+  pool.acquire()
+      .map(move_into{semaphorePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(pool.created_count() == 1);
+  REQUIRE(pool.available() == 0);
 }
\ No newline at end of file
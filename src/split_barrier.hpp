@@ -0,0 +1,250 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <tl/expected.hpp>
+#include <vector>
+#include "barrier_batcher.hpp"
+#include "event.hpp"
+#include "sync_helper.hpp"
+
+namespace vka {
+struct split_stats {
+  uint64_t events = {};
+  uint64_t waits = {};
+};
+
+// Schedules barriers between steps of a command buffer,
+// e.g. the passes of a frame, by how far apart producer and
+// consumer are. A dependency on the next step is an
+// ordinary barrier before it. A farther one is split: an
+// event is set right after the producing step and waited on
+// just before the consuming step, so the steps in between
+// overlap with it instead of draining the pipeline. Steps
+// must be recorded outside render passes.
+struct split_barrier_scheduler {
+  explicit split_barrier_scheduler(
+      VkCommandBuffer cmd,
+      event_pool& events,
+      uint32_t minSplitDistance = 2)
+      : m_cmd(cmd),
+        m_events(events),
+        m_minSplitDistance(minSplitDistance),
+        m_nearBarriers(cmd) {}
+
+  split_barrier_scheduler(const split_barrier_scheduler&) =
+      delete;
+  split_barrier_scheduler(split_barrier_scheduler&&) =
+      default;
+  split_barrier_scheduler& operator=(
+      const split_barrier_scheduler&) = delete;
+  split_barrier_scheduler& operator=(
+      split_barrier_scheduler&&) = delete;
+
+  // Declares that step consumer, after the current one,
+  // depends on accesses made in the current step. Call
+  // once the step's commands are recorded. Queue family
+  // ownership transfers cannot wait on events and always
+  // become barriers before the next step.
+  void global(
+      uint32_t consumer,
+      const ThsvsGlobalBarrier& barrier) {
+    if (adjacent(consumer)) {
+      m_nearBarriers.global(barrier);
+      return;
+    }
+    VkPipelineStageFlags srcStages = {};
+    VkPipelineStageFlags dstStages = {};
+    VkMemoryBarrier memoryBarrier = {};
+    thsvsGetVulkanMemoryBarrier(
+        barrier, &srcStages, &dstStages, &memoryBarrier);
+    auto& wait = producing(consumer, srcStages, dstStages);
+    wait.memoryBarrier.srcAccessMask |=
+        memoryBarrier.srcAccessMask;
+    wait.memoryBarrier.dstAccessMask |=
+        memoryBarrier.dstAccessMask;
+    wait.hasMemoryBarrier = true;
+  }
+
+  void buffer(
+      uint32_t consumer,
+      const ThsvsBufferBarrier& barrier) {
+    if (adjacent(consumer) ||
+        transfers_ownership(barrier)) {
+      m_nearBarriers.buffer(barrier);
+      return;
+    }
+    VkPipelineStageFlags srcStages = {};
+    VkPipelineStageFlags dstStages = {};
+    VkBufferMemoryBarrier bufferBarrier = {};
+    thsvsGetVulkanBufferMemoryBarrier(
+        barrier, &srcStages, &dstStages, &bufferBarrier);
+    producing(consumer, srcStages, dstStages)
+        .bufferBarriers.push_back(bufferBarrier);
+  }
+
+  void image(
+      uint32_t consumer,
+      const ThsvsImageBarrier& barrier) {
+    if (adjacent(consumer) ||
+        transfers_ownership(barrier)) {
+      m_nearBarriers.image(barrier);
+      return;
+    }
+    VkPipelineStageFlags srcStages = {};
+    VkPipelineStageFlags dstStages = {};
+    VkImageMemoryBarrier imageBarrier = {};
+    thsvsGetVulkanImageMemoryBarrier(
+        barrier, &srcStages, &dstStages, &imageBarrier);
+    producing(consumer, srcStages, dstStages)
+        .imageBarriers.push_back(imageBarrier);
+  }
+
+  // Records the barriers the current step waits on; call
+  // before recording its commands.
+  void begin_step() {
+    m_nearBarriers.flush();
+    auto waitsIt = m_waits.find(m_step);
+    if (waitsIt == m_waits.end()) {
+      return;
+    }
+
+    VkPipelineStageFlags srcStages = {};
+    VkPipelineStageFlags dstStages = {};
+    VkMemoryBarrier memoryBarrier = {
+        VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    auto hasMemoryBarrier = false;
+    m_eventHandles.clear();
+    m_bufferBarriers.clear();
+    m_imageBarriers.clear();
+    for (auto& wait : waitsIt->second) {
+      m_eventHandles.push_back(*wait.eventPtr);
+      srcStages |= wait.srcStages;
+      dstStages |= wait.dstStages;
+      memoryBarrier.srcAccessMask |=
+          wait.memoryBarrier.srcAccessMask;
+      memoryBarrier.dstAccessMask |=
+          wait.memoryBarrier.dstAccessMask;
+      hasMemoryBarrier =
+          hasMemoryBarrier || wait.hasMemoryBarrier;
+      m_bufferBarriers.insert(
+          m_bufferBarriers.end(),
+          wait.bufferBarriers.begin(),
+          wait.bufferBarriers.end());
+      m_imageBarriers.insert(
+          m_imageBarriers.end(),
+          wait.imageBarriers.begin(),
+          wait.imageBarriers.end());
+    }
+    vkCmdWaitEvents(
+        m_cmd,
+        static_cast<uint32_t>(m_eventHandles.size()),
+        m_eventHandles.data(),
+        srcStages,
+        dstStages,
+        hasMemoryBarrier ? 1 : 0,
+        hasMemoryBarrier ? &memoryBarrier : nullptr,
+        static_cast<uint32_t>(m_bufferBarriers.size()),
+        m_bufferBarriers.data(),
+        static_cast<uint32_t>(m_imageBarriers.size()),
+        m_imageBarriers.data());
+    ++m_stats.waits;
+    for (auto& wait : waitsIt->second) {
+      m_used.push_back(std::move(wait.eventPtr));
+    }
+    m_waits.erase(waitsIt);
+  }
+
+  // Sets one event per later step that depends on the
+  // current one, then moves on to the next step.
+  tl::expected<void, VkResult> end_step() {
+    for (auto& entry : m_producing) {
+      auto eventResult = m_events.acquire();
+      if (!eventResult) {
+        return tl::make_unexpected(eventResult.error());
+      }
+      auto& wait = entry.second;
+      wait.eventPtr = std::move(*eventResult);
+      vkCmdSetEvent(m_cmd, *wait.eventPtr, wait.srcStages);
+      ++m_stats.events;
+      m_waits[entry.first].push_back(std::move(wait));
+    }
+    m_producing.clear();
+    ++m_step;
+    return {};
+  }
+
+  // Hands the events back to the pool, to be reused once
+  // submitFence has signaled. Call before submitting this
+  // command buffer with submitFence.
+  void finish(VkFence submitFence) {
+    for (auto& waits : m_waits) {
+      for (auto& wait : waits.second) {
+        m_used.push_back(std::move(wait.eventPtr));
+      }
+    }
+    m_waits.clear();
+    for (auto& eventPtr : m_used) {
+      m_events.release(std::move(eventPtr), submitFence);
+    }
+    m_used.clear();
+  }
+
+  uint32_t step() const noexcept { return m_step; }
+
+  split_stats stats() const noexcept { return m_stats; }
+
+  // Barriers for dependencies on the next step.
+  barrier_stats near_stats() const noexcept {
+    return m_nearBarriers.stats();
+  }
+
+private:
+  struct event_wait {
+    std::unique_ptr<event> eventPtr = {};
+    VkPipelineStageFlags srcStages = {};
+    VkPipelineStageFlags dstStages = {};
+    VkMemoryBarrier memoryBarrier = {
+        VK_STRUCTURE_TYPE_MEMORY_BARRIER};
+    bool hasMemoryBarrier = {};
+    std::vector<VkBufferMemoryBarrier> bufferBarriers = {};
+    std::vector<VkImageMemoryBarrier> imageBarriers = {};
+  };
+
+  bool adjacent(uint32_t consumer) const noexcept {
+    return consumer < m_step + m_minSplitDistance;
+  }
+
+  template <typename Barrier>
+  static bool transfers_ownership(
+      const Barrier& barrier) noexcept {
+    return barrier.srcQueueFamilyIndex !=
+           barrier.dstQueueFamilyIndex;
+  }
+
+  event_wait& producing(
+      uint32_t consumer,
+      VkPipelineStageFlags srcStages,
+      VkPipelineStageFlags dstStages) {
+    auto& wait = m_producing[consumer];
+    wait.srcStages |= srcStages;
+    wait.dstStages |= dstStages;
+    return wait;
+  }
+
+  VkCommandBuffer m_cmd = {};
+  event_pool& m_events;
+  uint32_t m_minSplitDistance = {};
+  uint32_t m_step = {};
+  barrier_batcher m_nearBarriers;
+  std::map<uint32_t, event_wait> m_producing = {};
+  std::map<uint32_t, std::vector<event_wait>> m_waits = {};
+  std::vector<std::unique_ptr<event>> m_used = {};
+  std::vector<VkEvent> m_eventHandles = {};
+  std::vector<VkBufferMemoryBarrier> m_bufferBarriers = {};
+  std::vector<VkImageMemoryBarrier> m_imageBarriers = {};
+  split_stats m_stats = {};
+};
+}  // namespace vka
@@ -0,0 +1,127 @@
+#include "split_barrier.hpp"
+
+#include <catch2/catch.hpp>
+#include "command_buffer.hpp"
+#include "command_pool.hpp"
+#include "device.hpp"
+#include "image.hpp"
+#include "instance.hpp"
+#include "memory_allocator.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue_family.hpp"
+
+using namespace vka;
+TEST_CASE("Split barriers wait on events far ahead") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<image> imagePtr = {};
+  image_builder{}
+      .gpu_only()
+      .format(VK_FORMAT_R8G8B8A8_UNORM)
+      .image_extent(64, 64)
+      .mip_levels(2)
+      .transfer_destination()
+      .sampled()
+      .type_2d()
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*allocatorPtr)
+      .map(move_into{imagePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<command_pool> commandPoolPtr = {};
+  command_pool_builder{}
+      .queue_family_index(queueFamily.familyIndex)
+      .build(*devicePtr)
+      .map(move_into{commandPoolPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<command_buffer> commandPtr = {};
+  command_buffer_allocator{}
+      .set_command_pool(commandPoolPtr.get())
+      .allocate(*devicePtr)
+      .map(move_into{commandPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkCommandBufferBeginInfo beginInfo = {
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+  REQUIRE(
+      vkBeginCommandBuffer(*commandPtr, &beginInfo) ==
+      VK_SUCCESS);
+
+  event_pool events{*devicePtr};
+  split_barrier_scheduler scheduler{*commandPtr, events};
+
+  ThsvsAccessType transferWrite =
+      THSVS_ACCESS_TRANSFER_WRITE;
+  ThsvsAccessType sampled =
+      THSVS_ACCESS_FRAGMENT_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+  ThsvsImageBarrier toSampled = {};
+  toSampled.prevAccessCount = 1;
+  toSampled.pPrevAccesses = &transferWrite;
+  toSampled.nextAccessCount = 1;
+  toSampled.pNextAccesses = &sampled;
+  toSampled.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  toSampled.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+  toSampled.image = *imagePtr;
+  toSampled.subresourceRange = {
+      VK_IMAGE_ASPECT_COLOR_BIT, 0, 1, 0, 1};
+
+  // step 0 writes both mips, step 1 samples mip 0 and
+  // step 3 samples mip 1
+  scheduler.begin_step();
+  scheduler.image(1, toSampled);
+  toSampled.subresourceRange.baseMipLevel = 1;
+  scheduler.image(3, toSampled);
+  REQUIRE(scheduler.end_step());
+  REQUIRE(scheduler.stats().events == 1);
+  for (uint32_t step = 1; step < 4; ++step) {
+    scheduler.begin_step();
+    REQUIRE(scheduler.end_step());
+  }
+  REQUIRE(scheduler.step() == 4);
+  REQUIRE(scheduler.stats().waits == 1);
+  REQUIRE(scheduler.near_stats().calls == 1);
+  REQUIRE(vkEndCommandBuffer(*commandPtr) == VK_SUCCESS);
+
+  scheduler.finish(VK_NULL_HANDLE);
+  REQUIRE(events.collect());
+  REQUIRE(events.available() == 1);
+}
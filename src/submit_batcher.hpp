@@ -0,0 +1,158 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <mutex>
+#include <tl/expected.hpp>
+#include <vector>
+#include "queue.hpp"
+
+namespace vka {
+struct submission {
+  std::vector<VkSemaphore> waitSemaphores = {};
+  std::vector<VkPipelineStageFlags> waitStages = {};
+  std::vector<VkCommandBuffer> commandBuffers = {};
+  std::vector<VkSemaphore> signalSemaphores = {};
+};
+
+struct submit_stats {
+  size_t submissions = {};
+  size_t submitInfos = {};
+  size_t calls = {};
+};
+
+// Collects submissions from any number of threads and
+// hands them to the queue in enqueue order, in as few
+// vkQueueSubmit calls as possible. A submission without
+// wait semaphores is folded into the previous
+// VkSubmitInfo when that one has no semaphores at all.
+// Only one fence fits in a call, so a fenced submission
+// ends its call; the fence then also covers the
+// submissions before it in that call.
+struct submit_batcher {
+  explicit submit_batcher(queue targetQueue)
+      : m_queue(targetQueue) {}
+
+  submit_batcher(const submit_batcher&) = delete;
+  submit_batcher(submit_batcher&&) = delete;
+  submit_batcher& operator=(const submit_batcher&) = delete;
+  submit_batcher& operator=(submit_batcher&&) = delete;
+
+  void enqueue(
+      submission work,
+      VkFence fence = VK_NULL_HANDLE) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_pending.push_back({std::move(work), fence});
+  }
+
+  // Submits everything enqueued so far. On failure the
+  // submissions from the failed call onward are dropped.
+  tl::expected<submit_stats, VkResult> flush() {
+    std::lock_guard<std::mutex> flushLock(m_flushMutex);
+    m_flushing.clear();
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_flushing.swap(m_pending);
+    }
+    build_calls();
+
+    submit_stats stats = {};
+    stats.submissions = m_flushing.size();
+    stats.submitInfos = m_infos.size();
+    stats.calls = m_calls.size();
+    for (auto& call : m_calls) {
+      auto result = m_queue.submit(
+          {m_infos.data() + call.firstInfo, call.infoCount},
+          call.fence);
+      if (!result) {
+        return tl::make_unexpected(result.error());
+      }
+    }
+    return stats;
+  }
+
+private:
+  struct pending_submission {
+    submission work = {};
+    VkFence fence = {};
+  };
+
+  struct submit_call {
+    size_t firstInfo = {};
+    size_t infoCount = {};
+    VkFence fence = {};
+  };
+
+  template <typename T>
+  static uint32_t count(const std::vector<T>& items) {
+    return static_cast<uint32_t>(items.size());
+  }
+
+  void build_calls() {
+    m_infos.clear();
+    m_calls.clear();
+    m_commandBuffers.clear();
+    m_firstCommands.clear();
+
+    size_t callStart = {};
+    auto canMerge = false;
+    for (auto& pending : m_flushing) {
+      auto& work = pending.work;
+      if (canMerge && work.waitSemaphores.empty()) {
+        auto& info = m_infos.back();
+        info.commandBufferCount +=
+            count(work.commandBuffers);
+      } else {
+        VkSubmitInfo info = {VK_STRUCTURE_TYPE_SUBMIT_INFO};
+        info.waitSemaphoreCount =
+            count(work.waitSemaphores);
+        info.pWaitSemaphores = work.waitSemaphores.data();
+        info.pWaitDstStageMask = work.waitStages.data();
+        info.commandBufferCount =
+            count(work.commandBuffers);
+        m_infos.push_back(info);
+        m_firstCommands.push_back(m_commandBuffers.size());
+      }
+      m_commandBuffers.insert(
+          m_commandBuffers.end(),
+          work.commandBuffers.begin(),
+          work.commandBuffers.end());
+
+      auto& info = m_infos.back();
+      info.signalSemaphoreCount =
+          count(work.signalSemaphores);
+      info.pSignalSemaphores = work.signalSemaphores.data();
+      canMerge = info.waitSemaphoreCount == 0 &&
+                 info.signalSemaphoreCount == 0;
+
+      if (pending.fence != VK_NULL_HANDLE) {
+        m_calls.push_back({callStart,
+                           m_infos.size() - callStart,
+                           pending.fence});
+        callStart = m_infos.size();
+        canMerge = false;
+      }
+    }
+    if (callStart < m_infos.size()) {
+      m_calls.push_back(
+          {callStart, m_infos.size() - callStart, {}});
+    }
+
+    // m_commandBuffers has stopped growing, so offsets can
+    // become pointers
+    for (size_t i = {}; i < m_infos.size(); ++i) {
+      m_infos[i].pCommandBuffers =
+          m_commandBuffers.data() + m_firstCommands[i];
+    }
+  }
+
+  queue m_queue;
+  std::mutex m_mutex = {};
+  std::vector<pending_submission> m_pending = {};
+  std::mutex m_flushMutex = {};
+  std::vector<pending_submission> m_flushing = {};
+  std::vector<VkSubmitInfo> m_infos = {};
+  std::vector<submit_call> m_calls = {};
+  std::vector<VkCommandBuffer> m_commandBuffers = {};
+  std::vector<size_t> m_firstCommands = {};
+};
+}  // namespace vka
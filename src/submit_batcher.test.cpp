@@ -0,0 +1,102 @@
+#include "submit_batcher.hpp"
+
+#include <catch2/catch.hpp>
+#include "device.hpp"
+#include "fence.hpp"
+#include "instance.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue_family.hpp"
+#include "semaphore.hpp"
+
+using namespace vka;
+TEST_CASE("Submit batcher coalesces submissions") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue graphicsQueue = {};
+  queue_builder{}
+      .queue_info(queueFamily, 0)
+      .build(*devicePtr)
+      .map(move_into{graphicsQueue})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<fence> firstFence = {};
+  fence_builder{}
+      .build(*devicePtr)
+      .map(move_into{firstFence})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<fence> secondFence = {};
+  fence_builder{}
+      .build(*devicePtr)
+      .map(move_into{secondFence})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<semaphore> link = {};
+  semaphore_builder{}
+      .build(*devicePtr)
+      .map(move_into{link})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  submit_batcher batcher{graphicsQueue};
+  batcher.enqueue({});
+  batcher.enqueue({}, *firstFence);
+
+  submission signaling = {};
+  signaling.signalSemaphores.push_back(*link);
+  batcher.enqueue(signaling);
+
+  submission waiting = {};
+  waiting.waitSemaphores.push_back(*link);
+  waiting.waitStages.push_back(
+      VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT);
+  batcher.enqueue(waiting, *secondFence);
+
+  submit_stats stats = {};
+  batcher.flush()
+      .map(move_into{stats})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(stats.submissions == 4);
+  REQUIRE(stats.submitInfos == 3);
+  REQUIRE(stats.calls == 2);
+
+  VkFence fences[] = {*firstFence, *secondFence};
+  REQUIRE(
+      vkWaitForFences(
+          *devicePtr, 2, fences, VK_TRUE, UINT64_MAX) ==
+      VK_SUCCESS);
+
+  batcher.flush()
+      .map(move_into{stats})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(stats.calls == 0);
+}
@@ -693,6 +693,53 @@ void thsvsCmdWaitEvents(
     uint32_t imageBarrierCount,
     const ThsvsImageBarrier* pImageBarriers);
 
+#ifdef VK_KHR_synchronization2
+/*
+Mapping function that translates a global barrier into a
+VkMemoryBarrier2KHR for VK_KHR_synchronization2. The source
+and destination stages are stored in the barrier itself.
+*/
+void thsvsGetVulkanMemoryBarrier2(
+    ThsvsGlobalBarrier thBarrier,
+    VkMemoryBarrier2KHR* pVkBarrier);
+
+/*
+Mapping function that translates a buffer barrier into a
+VkBufferMemoryBarrier2KHR for VK_KHR_synchronization2.
+*/
+void thsvsGetVulkanBufferMemoryBarrier2(
+    ThsvsBufferBarrier thBarrier,
+    VkBufferMemoryBarrier2KHR* pVkBarrier);
+
+/*
+Mapping function that translates an image barrier into a
+VkImageMemoryBarrier2KHR for VK_KHR_synchronization2.
+*/
+void thsvsGetVulkanImageMemoryBarrier2(
+    ThsvsImageBarrier thBarrier,
+    VkImageMemoryBarrier2KHR* pVkBarrier);
+
+/*
+Simplified wrapper around vkCmdPipelineBarrier2KHR.
+
+Unlike thsvsCmdPipelineBarrier, each barrier keeps its own
+stage masks, so unrelated barriers recorded in the same call
+do not wait on each other's stages.
+
+vkCmdPipelineBarrier2KHR is not exported by the loader, so
+it is passed in as pfnCmdPipelineBarrier2, e.g. as returned
+by vkGetDeviceProcAddr. commandBuffer is passed unmodified.
+*/
+void thsvsCmdPipelineBarrier2(
+    PFN_vkCmdPipelineBarrier2KHR pfnCmdPipelineBarrier2,
+    VkCommandBuffer commandBuffer,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t imageBarrierCount,
+    const ThsvsImageBarrier* pImageBarriers);
+#endif  // VK_KHR_synchronization2
+
 #endif  // THSVS_SIMPLER_VULKAN_SYNCHRONIZATION_H
 
 #ifdef THSVS_SIMPLER_VULKAN_SYNCHRONIZATION_IMPLEMENTATION
@@ -1548,4 +1595,142 @@ void thsvsCmdWaitEvents(
   THSVS_TEMP_FREE(pImageMemoryBarriers);
 }
 
+#ifdef VK_KHR_synchronization2
+// The synchronization2 mappings reuse the ones above: the
+// legacy stage and access bits keep their values in the
+// 64-bit VkPipelineStageFlags2KHR and VkAccessFlags2KHR.
+void thsvsGetVulkanMemoryBarrier2(
+    ThsvsGlobalBarrier thBarrier,
+    VkMemoryBarrier2KHR* pVkBarrier) {
+  VkPipelineStageFlags srcStages = 0;
+  VkPipelineStageFlags dstStages = 0;
+  VkMemoryBarrier vkBarrier;
+  thsvsGetVulkanMemoryBarrier(
+      thBarrier, &srcStages, &dstStages, &vkBarrier);
+
+  pVkBarrier->sType =
+      VK_STRUCTURE_TYPE_MEMORY_BARRIER_2_KHR;
+  pVkBarrier->pNext = NULL;
+  pVkBarrier->srcStageMask = srcStages;
+  pVkBarrier->srcAccessMask = vkBarrier.srcAccessMask;
+  pVkBarrier->dstStageMask = dstStages;
+  pVkBarrier->dstAccessMask = vkBarrier.dstAccessMask;
+}
+
+void thsvsGetVulkanBufferMemoryBarrier2(
+    ThsvsBufferBarrier thBarrier,
+    VkBufferMemoryBarrier2KHR* pVkBarrier) {
+  VkPipelineStageFlags srcStages = 0;
+  VkPipelineStageFlags dstStages = 0;
+  VkBufferMemoryBarrier vkBarrier;
+  thsvsGetVulkanBufferMemoryBarrier(
+      thBarrier, &srcStages, &dstStages, &vkBarrier);
+
+  pVkBarrier->sType =
+      VK_STRUCTURE_TYPE_BUFFER_MEMORY_BARRIER_2_KHR;
+  pVkBarrier->pNext = NULL;
+  pVkBarrier->srcStageMask = srcStages;
+  pVkBarrier->srcAccessMask = vkBarrier.srcAccessMask;
+  pVkBarrier->dstStageMask = dstStages;
+  pVkBarrier->dstAccessMask = vkBarrier.dstAccessMask;
+  pVkBarrier->srcQueueFamilyIndex =
+      vkBarrier.srcQueueFamilyIndex;
+  pVkBarrier->dstQueueFamilyIndex =
+      vkBarrier.dstQueueFamilyIndex;
+  pVkBarrier->buffer = vkBarrier.buffer;
+  pVkBarrier->offset = vkBarrier.offset;
+  pVkBarrier->size = vkBarrier.size;
+}
+
+void thsvsGetVulkanImageMemoryBarrier2(
+    ThsvsImageBarrier thBarrier,
+    VkImageMemoryBarrier2KHR* pVkBarrier) {
+  VkPipelineStageFlags srcStages = 0;
+  VkPipelineStageFlags dstStages = 0;
+  VkImageMemoryBarrier vkBarrier;
+  thsvsGetVulkanImageMemoryBarrier(
+      thBarrier, &srcStages, &dstStages, &vkBarrier);
+
+  pVkBarrier->sType =
+      VK_STRUCTURE_TYPE_IMAGE_MEMORY_BARRIER_2_KHR;
+  pVkBarrier->pNext = NULL;
+  pVkBarrier->srcStageMask = srcStages;
+  pVkBarrier->srcAccessMask = vkBarrier.srcAccessMask;
+  pVkBarrier->dstStageMask = dstStages;
+  pVkBarrier->dstAccessMask = vkBarrier.dstAccessMask;
+  pVkBarrier->oldLayout = vkBarrier.oldLayout;
+  pVkBarrier->newLayout = vkBarrier.newLayout;
+  pVkBarrier->srcQueueFamilyIndex =
+      vkBarrier.srcQueueFamilyIndex;
+  pVkBarrier->dstQueueFamilyIndex =
+      vkBarrier.dstQueueFamilyIndex;
+  pVkBarrier->image = vkBarrier.image;
+  pVkBarrier->subresourceRange = vkBarrier.subresourceRange;
+}
+
+void thsvsCmdPipelineBarrier2(
+    PFN_vkCmdPipelineBarrier2KHR pfnCmdPipelineBarrier2,
+    VkCommandBuffer commandBuffer,
+    const ThsvsGlobalBarrier* pGlobalBarrier,
+    uint32_t bufferBarrierCount,
+    const ThsvsBufferBarrier* pBufferBarriers,
+    uint32_t imageBarrierCount,
+    const ThsvsImageBarrier* pImageBarriers) {
+  VkMemoryBarrier2KHR memoryBarrier;
+  VkDependencyInfoKHR dependencyInfo;
+  dependencyInfo.sType =
+      VK_STRUCTURE_TYPE_DEPENDENCY_INFO_KHR;
+  dependencyInfo.pNext = NULL;
+  dependencyInfo.dependencyFlags = 0;
+  dependencyInfo.memoryBarrierCount =
+      (pGlobalBarrier != NULL) ? 1 : 0;
+  dependencyInfo.pMemoryBarriers =
+      (pGlobalBarrier != NULL) ? &memoryBarrier : NULL;
+  dependencyInfo.bufferMemoryBarrierCount =
+      bufferBarrierCount;
+  dependencyInfo.pBufferMemoryBarriers = NULL;
+  dependencyInfo.imageMemoryBarrierCount =
+      imageBarrierCount;
+  dependencyInfo.pImageMemoryBarriers = NULL;
+
+  // Global memory barrier
+  if (pGlobalBarrier != NULL)
+    thsvsGetVulkanMemoryBarrier2(
+        *pGlobalBarrier, &memoryBarrier);
+
+  // Buffer memory barriers
+  VkBufferMemoryBarrier2KHR* pBufferMemoryBarriers = NULL;
+  if (bufferBarrierCount > 0) {
+    pBufferMemoryBarriers =
+        (VkBufferMemoryBarrier2KHR*)THSVS_TEMP_ALLOC(
+            sizeof(VkBufferMemoryBarrier2KHR) *
+            bufferBarrierCount);
+    for (uint32_t i = 0; i < bufferBarrierCount; ++i)
+      thsvsGetVulkanBufferMemoryBarrier2(
+          pBufferBarriers[i], &pBufferMemoryBarriers[i]);
+    dependencyInfo.pBufferMemoryBarriers =
+        pBufferMemoryBarriers;
+  }
+
+  // Image memory barriers
+  VkImageMemoryBarrier2KHR* pImageMemoryBarriers = NULL;
+  if (imageBarrierCount > 0) {
+    pImageMemoryBarriers =
+        (VkImageMemoryBarrier2KHR*)THSVS_TEMP_ALLOC(
+            sizeof(VkImageMemoryBarrier2KHR) *
+            imageBarrierCount);
+    for (uint32_t i = 0; i < imageBarrierCount; ++i)
+      thsvsGetVulkanImageMemoryBarrier2(
+          pImageBarriers[i], &pImageMemoryBarriers[i]);
+    dependencyInfo.pImageMemoryBarriers =
+        pImageMemoryBarriers;
+  }
+
+  pfnCmdPipelineBarrier2(commandBuffer, &dependencyInfo);
+
+  THSVS_TEMP_FREE(pBufferMemoryBarriers);
+  THSVS_TEMP_FREE(pImageMemoryBarriers);
+}
+#endif  // VK_KHR_synchronization2
+
 #endif  // THSVS_SIMPLER_VULKAN_SYNCHRONIZATION_IMPLEMENTATION
@@ -0,0 +1,269 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <tl/expected.hpp>
+#include <vector>
+#include "queue.hpp"
+#include "timeline_semaphore.hpp"
+#include "worker_pool.hpp"
+
+#ifdef VK_KHR_timeline_semaphore
+namespace vka {
+// A value on one track's timeline; reached once the node
+// that was given it has finished.
+struct timeline_point {
+  uint32_t track = {};
+  uint64_t value = {};
+};
+
+// Work split into tracks, each a queue or the CPU worker
+// pool, with one timeline semaphore per track. Every node
+// signals the next value of its track, and depends on
+// points of any track by value, so GPU work can wait on a
+// CPU job that has not run yet and the other way around.
+// Nodes of one track run in the order they were added.
+struct timeline_graph {
+  explicit timeline_graph(worker_pool& cpuWorkers)
+      : m_cpuWorkers(cpuWorkers) {}
+
+  tl::expected<uint32_t, VkResult> add_queue_track(
+      queue targetQueue,
+      timeline_semaphore& semaphore) {
+    return add_track(&targetQueue, semaphore);
+  }
+
+  tl::expected<uint32_t, VkResult> add_cpu_track(
+      timeline_semaphore& semaphore) {
+    return add_track(nullptr, semaphore);
+  }
+
+  timeline_point gpu(
+      uint32_t track,
+      std::vector<VkCommandBuffer> commandBuffers,
+      const std::vector<timeline_point>& dependencies,
+      VkPipelineStageFlags waitStage =
+          VK_PIPELINE_STAGE_ALL_COMMANDS_BIT) {
+    auto& node = add_node(track, dependencies);
+    node.commandBuffers = std::move(commandBuffers);
+    node.waitStages.assign(
+        node.waitSemaphores.size(), waitStage);
+    return {track, node.value};
+  }
+
+  timeline_point cpu(
+      uint32_t track,
+      std::function<void()> job,
+      const std::vector<timeline_point>& dependencies) {
+    auto& node = add_node(track, dependencies);
+    node.job = std::move(job);
+    return {track, node.value};
+  }
+
+  // Submits the GPU nodes of each queue track in a single
+  // vkQueueSubmit and hands the CPU nodes to the worker
+  // pool, then forgets them. The semaphores must outlive
+  // the work. If a queue submission fails, the values of
+  // every queue track not submitted are signaled from the
+  // host and the CPU nodes skip their jobs and only signal,
+  // so neither queues submitted before it nor later nodes
+  // wait forever.
+  tl::expected<void, VkResult> submit() {
+    tl::expected<void, VkResult> result = {};
+    for (uint32_t track = {}; track < m_tracks.size();
+         ++track) {
+      if (!m_tracks[track].isQueue) {
+        continue;
+      }
+      if (result) {
+        result = submit_queue_track(track);
+      }
+      if (!result) {
+        abandon_queue_track(track);
+      }
+    }
+    for (auto& node : m_nodes) {
+      if (!m_tracks[node.track].isQueue) {
+        node.abandoned = !result;
+        dispatch_cpu_node(std::move(node));
+      }
+    }
+    m_nodes.clear();
+    return result;
+  }
+
+  // The value the track reaches once all its nodes so far
+  // have run.
+  uint64_t last_value(uint32_t track) const noexcept {
+    return m_tracks[track].lastValue;
+  }
+
+private:
+  struct track_state {
+    bool isQueue = {};
+    queue targetQueue = {};
+    timeline_semaphore* semaphore = {};
+    uint64_t lastValue = {};
+  };
+
+  struct graph_node {
+    uint32_t track = {};
+    uint64_t value = {};
+    std::vector<timeline_semaphore*> waitTimelines = {};
+    std::vector<VkSemaphore> waitSemaphores = {};
+    std::vector<uint64_t> waitValues = {};
+    std::vector<VkPipelineStageFlags> waitStages = {};
+    std::vector<VkCommandBuffer> commandBuffers = {};
+    VkSemaphore signalSemaphore = {};
+    std::function<void()> job = {};
+    bool abandoned = {};
+  };
+
+  tl::expected<uint32_t, VkResult> add_track(
+      queue* targetQueue,
+      timeline_semaphore& semaphore) {
+    auto valueResult = semaphore.value();
+    if (!valueResult) {
+      return tl::make_unexpected(valueResult.error());
+    }
+    track_state state = {};
+    state.isQueue = targetQueue != nullptr;
+    if (targetQueue) {
+      state.targetQueue = *targetQueue;
+    }
+    state.semaphore = &semaphore;
+    state.lastValue = *valueResult;
+    m_tracks.push_back(state);
+    return static_cast<uint32_t>(m_tracks.size() - 1);
+  }
+
+  // Waits on the highest value needed from each track,
+  // including the previous value of the node's own track.
+  graph_node& add_node(
+      uint32_t track,
+      const std::vector<timeline_point>& dependencies) {
+    m_waitValues.assign(m_tracks.size(), 0);
+    m_waitValues[track] = m_tracks[track].lastValue;
+    for (auto& dependency : dependencies) {
+      auto& waitValue = m_waitValues[dependency.track];
+      waitValue = std::max(waitValue, dependency.value);
+    }
+
+    graph_node node = {};
+    node.track = track;
+    node.value = ++m_tracks[track].lastValue;
+    node.signalSemaphore = *m_tracks[track].semaphore;
+    for (uint32_t i = {}; i < m_tracks.size(); ++i) {
+      if (m_waitValues[i] == 0) {
+        continue;
+      }
+      node.waitTimelines.push_back(m_tracks[i].semaphore);
+      node.waitSemaphores.push_back(*m_tracks[i].semaphore);
+      node.waitValues.push_back(m_waitValues[i]);
+    }
+    m_nodes.push_back(std::move(node));
+    return m_nodes.back();
+  }
+
+  tl::expected<void, VkResult> submit_queue_track(
+      uint32_t track) {
+    m_timelineInfos.clear();
+    m_submitInfos.clear();
+    for (auto& node : m_nodes) {
+      if (node.track != track) {
+        continue;
+      }
+      VkTimelineSemaphoreSubmitInfoKHR timelineInfo = {
+          VK_STRUCTURE_TYPE_TIMELINE_SEMAPHORE_SUBMIT_INFO_KHR};
+      timelineInfo.waitSemaphoreValueCount =
+          static_cast<uint32_t>(node.waitValues.size());
+      timelineInfo.pWaitSemaphoreValues =
+          node.waitValues.data();
+      timelineInfo.signalSemaphoreValueCount = 1;
+      timelineInfo.pSignalSemaphoreValues = &node.value;
+      m_timelineInfos.push_back(timelineInfo);
+
+      VkSubmitInfo submitInfo = {
+          VK_STRUCTURE_TYPE_SUBMIT_INFO};
+      submitInfo.waitSemaphoreCount =
+          static_cast<uint32_t>(node.waitSemaphores.size());
+      submitInfo.pWaitSemaphores =
+          node.waitSemaphores.data();
+      submitInfo.pWaitDstStageMask = node.waitStages.data();
+      submitInfo.commandBufferCount =
+          static_cast<uint32_t>(node.commandBuffers.size());
+      submitInfo.pCommandBuffers =
+          node.commandBuffers.data();
+      submitInfo.signalSemaphoreCount = 1;
+      submitInfo.pSignalSemaphores = &node.signalSemaphore;
+      m_submitInfos.push_back(submitInfo);
+    }
+    if (m_submitInfos.empty()) {
+      return {};
+    }
+    // m_timelineInfos has stopped growing
+    for (size_t i = {}; i < m_submitInfos.size(); ++i) {
+      m_submitInfos[i].pNext = &m_timelineInfos[i];
+    }
+    return m_tracks[track].targetQueue.submit(
+        m_submitInfos);
+  }
+
+  // Signals the track's values of this submit() from the
+  // host once its earlier work is done, as a host signal
+  // may not overtake a pending one.
+  void abandon_queue_track(uint32_t track) {
+    auto first = std::find_if(
+        m_nodes.begin(), m_nodes.end(), [&](auto& node) {
+          return node.track == track;
+        });
+    if (first == m_nodes.end()) {
+      return;
+    }
+    auto semaphore = m_tracks[track].semaphore;
+    auto previousValue = first->value - 1;
+    auto lastValue = m_tracks[track].lastValue;
+    m_cpuWorkers.submit(
+        [semaphore, previousValue, lastValue] {
+          semaphore->wait(previousValue);
+          semaphore->signal(lastValue);
+        });
+  }
+
+  // An abandoned node waits only for its own track, whose
+  // values are always signaled, and skips its job.
+  void dispatch_cpu_node(graph_node node) {
+    auto signalTimeline = m_tracks[node.track].semaphore;
+    m_cpuWorkers.submit(
+        [node = std::move(node), signalTimeline] {
+          auto ready = true;
+          for (size_t i = {}; i < node.waitTimelines.size();
+               ++i) {
+            if (node.abandoned &&
+                node.waitTimelines[i] != signalTimeline) {
+              continue;
+            }
+            ready = ready && node.waitTimelines[i]->wait(
+                                 node.waitValues[i]);
+          }
+          if (ready && !node.abandoned) {
+            node.job();
+          }
+          // signaled even on failure, so dependents are not
+          // left waiting forever
+          signalTimeline->signal(node.value);
+        });
+  }
+
+  worker_pool& m_cpuWorkers;
+  std::vector<track_state> m_tracks = {};
+  std::vector<graph_node> m_nodes = {};
+  std::vector<uint64_t> m_waitValues = {};
+  std::vector<VkTimelineSemaphoreSubmitInfoKHR>
+      m_timelineInfos = {};
+  std::vector<VkSubmitInfo> m_submitInfos = {};
+};
+}  // namespace vka
+#endif
@@ -0,0 +1,92 @@
+#include "timeline_graph.hpp"
+
+#include <atomic>
+#include <catch2/catch.hpp>
+#include "device.hpp"
+#include "instance.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue_family.hpp"
+
+#ifdef VK_KHR_timeline_semaphore
+using namespace vka;
+TEST_CASE("Timeline graph orders CPU and GPU nodes") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .physical_device_properties2()
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .timeline_semaphore()
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue graphicsQueue = {};
+  queue_builder{}
+      .queue_info(queueFamily, 0)
+      .build(*devicePtr)
+      .map(move_into{graphicsQueue})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<timeline_semaphore> gpuTimeline = {};
+  timeline_semaphore_builder{}
+      .build(*devicePtr)
+      .map(move_into{gpuTimeline})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<timeline_semaphore> cpuTimeline = {};
+  timeline_semaphore_builder{}
+      .build(*devicePtr)
+      .map(move_into{cpuTimeline})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  worker_pool workers{2};
+  timeline_graph graph{workers};
+  uint32_t gpuTrack = {};
+  graph.add_queue_track(graphicsQueue, *gpuTimeline)
+      .map(move_into{gpuTrack})
+      .map_error([](auto error) { REQUIRE(false); });
+  uint32_t cpuTrack = {};
+  graph.add_cpu_track(*cpuTimeline)
+      .map(move_into{cpuTrack})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::atomic<int> stage = {};
+  auto prepare =
+      graph.cpu(cpuTrack, [&] { stage = 1; }, {});
+  auto render = graph.gpu(gpuTrack, {}, {prepare});
+  auto readback = graph.cpu(
+      cpuTrack, [&] { stage = stage * 10 + 2; }, {render});
+  REQUIRE(render.value == 1);
+  REQUIRE(readback.value == 2);
+  REQUIRE(graph.last_value(cpuTrack) == 2);
+
+  REQUIRE(graph.submit());
+  REQUIRE(cpuTimeline->wait(readback.value));
+  REQUIRE(gpuTimeline->wait(render.value));
+  REQUIRE(stage == 12);
+}
+#endif
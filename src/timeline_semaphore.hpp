@@ -0,0 +1,160 @@
+#pragma once
+
+#include <vulkan/vulkan.h>
+#include <cstdint>
+#include <memory>
+#include <tl/expected.hpp>
+
+#ifdef VK_KHR_timeline_semaphore
+namespace vka {
+// Entry points of VK_KHR_timeline_semaphore, which the
+// loader does not export directly.
+struct timeline_functions {
+  PFN_vkGetSemaphoreCounterValueKHR getCounterValue = {};
+  PFN_vkWaitSemaphoresKHR waitSemaphores = {};
+  PFN_vkSignalSemaphoreKHR signalSemaphore = {};
+
+  static tl::expected<timeline_functions, VkResult> load(
+      VkDevice device) {
+    timeline_functions functions = {};
+    functions.getCounterValue =
+        reinterpret_cast<PFN_vkGetSemaphoreCounterValueKHR>(
+            vkGetDeviceProcAddr(
+                device, "vkGetSemaphoreCounterValueKHR"));
+    functions.waitSemaphores =
+        reinterpret_cast<PFN_vkWaitSemaphoresKHR>(
+            vkGetDeviceProcAddr(
+                device, "vkWaitSemaphoresKHR"));
+    functions.signalSemaphore =
+        reinterpret_cast<PFN_vkSignalSemaphoreKHR>(
+            vkGetDeviceProcAddr(
+                device, "vkSignalSemaphoreKHR"));
+    if (!functions.getCounterValue ||
+        !functions.waitSemaphores ||
+        !functions.signalSemaphore) {
+      return tl::make_unexpected(
+          VK_ERROR_EXTENSION_NOT_PRESENT);
+    }
+    return functions;
+  }
+};
+
+struct timeline_semaphore {
+  explicit timeline_semaphore(
+      VkDevice device,
+      VkSemaphore semaphoreHandle,
+      timeline_functions functions)
+      : m_device(device),
+        m_semaphore(semaphoreHandle),
+        m_functions(functions) {}
+
+  timeline_semaphore(const timeline_semaphore&) = delete;
+  timeline_semaphore(timeline_semaphore&&) = default;
+  timeline_semaphore& operator=(const timeline_semaphore&) =
+      delete;
+  timeline_semaphore& operator=(timeline_semaphore&&) =
+      default;
+
+  ~timeline_semaphore() noexcept {
+    vkDestroySemaphore(m_device, m_semaphore, nullptr);
+  }
+
+  operator VkSemaphore() const noexcept {
+    return m_semaphore;
+  }
+
+  tl::expected<uint64_t, VkResult> value() const {
+    uint64_t counter = {};
+    auto result = m_functions.getCounterValue(
+        m_device, m_semaphore, &counter);
+    if (result != VK_SUCCESS) {
+      return tl::make_unexpected(result);
+    }
+    return counter;
+  }
+
+  // Signals from the host. value must be greater than the
+  // current value and than any pending signal.
+  tl::expected<void, VkResult> signal(uint64_t value) {
+    VkSemaphoreSignalInfoKHR signalInfo = {
+        VK_STRUCTURE_TYPE_SEMAPHORE_SIGNAL_INFO_KHR};
+    signalInfo.semaphore = m_semaphore;
+    signalInfo.value = value;
+    auto result =
+        m_functions.signalSemaphore(m_device, &signalInfo);
+    if (result != VK_SUCCESS) {
+      return tl::make_unexpected(result);
+    }
+    return {};
+  }
+
+  // Blocks until the counter reaches value. Fails with
+  // VK_TIMEOUT if it does not within timeout nanoseconds.
+  tl::expected<void, VkResult> wait(
+      uint64_t value,
+      uint64_t timeout = UINT64_MAX) const {
+    VkSemaphoreWaitInfoKHR waitInfo = {
+        VK_STRUCTURE_TYPE_SEMAPHORE_WAIT_INFO_KHR};
+    waitInfo.semaphoreCount = 1;
+    waitInfo.pSemaphores = &m_semaphore;
+    waitInfo.pValues = &value;
+    auto result = m_functions.waitSemaphores(
+        m_device, &waitInfo, timeout);
+    if (result != VK_SUCCESS) {
+      return tl::make_unexpected(result);
+    }
+    return {};
+  }
+
+  const timeline_functions& functions() const noexcept {
+    return m_functions;
+  }
+
+private:
+  VkDevice m_device = {};
+  VkSemaphore m_semaphore = {};
+  timeline_functions m_functions = {};
+};
+
+// The device must have been built with
+// device_builder::timeline_semaphore().
+struct timeline_semaphore_builder {
+  tl::expected<
+      std::unique_ptr<timeline_semaphore>,
+      VkResult>
+  build(VkDevice device) {
+    auto functionsResult = timeline_functions::load(device);
+    if (!functionsResult) {
+      return tl::make_unexpected(functionsResult.error());
+    }
+
+    VkSemaphoreTypeCreateInfoKHR typeInfo = {
+        VK_STRUCTURE_TYPE_SEMAPHORE_TYPE_CREATE_INFO_KHR};
+    typeInfo.semaphoreType = VK_SEMAPHORE_TYPE_TIMELINE_KHR;
+    typeInfo.initialValue = m_initialValue;
+    VkSemaphoreCreateInfo createInfo = {
+        VK_STRUCTURE_TYPE_SEMAPHORE_CREATE_INFO};
+    createInfo.pNext = &typeInfo;
+
+    VkSemaphore semaphoreHandle = {};
+    auto result = vkCreateSemaphore(
+        device, &createInfo, nullptr, &semaphoreHandle);
+    if (result != VK_SUCCESS) {
+      return tl::make_unexpected(result);
+    }
+
+    return std::make_unique<timeline_semaphore>(
+        device, semaphoreHandle, *functionsResult);
+  }
+
+  timeline_semaphore_builder& initial_value(
+      uint64_t value) {
+    m_initialValue = value;
+    return *this;
+  }
+
+private:
+  uint64_t m_initialValue = {};
+};
+}  // namespace vka
+#endif
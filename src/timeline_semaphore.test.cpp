@@ -0,0 +1,70 @@
+#include "timeline_semaphore.hpp"
+
+#include <catch2/catch.hpp>
+#include "device.hpp"
+#include "instance.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue_family.hpp"
+
+#ifdef VK_KHR_timeline_semaphore
+using namespace vka;
+TEST_CASE("Signal and wait on a timeline semaphore") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .physical_device_properties2()
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family queueFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{queueFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<device> devicePtr = {};
+  device_builder{}
+      .add_queue_family(queueFamily)
+      .physical_device(physicalDevice)
+      .timeline_semaphore()
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<timeline_semaphore> timelinePtr = {};
+  timeline_semaphore_builder{}
+      .initial_value(5)
+      .build(*devicePtr)
+      .map(move_into{timelinePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  uint64_t value = {};
+  timelinePtr->value()
+      .map(move_into{value})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(value == 5);
+
+  auto early = timelinePtr->wait(6, 0);
+  REQUIRE(!early);
+  REQUIRE(early.error() == VK_TIMEOUT);
+
+  REQUIRE(timelinePtr->signal(6));
+  REQUIRE(timelinePtr->wait(6));
+  timelinePtr->value()
+      .map(move_into{value})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(value == 6);
+}
+#endif
@@ -0,0 +1,622 @@
+#pragma once
+
+#include <vk_mem_alloc.h>
+#include <vulkan/vulkan.h>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <memory>
+#include <tl/expected.hpp>
+#include <vector>
+#include "command_buffer.hpp"
+#include "command_pool.hpp"
+#include "fence.hpp"
+#include "gsl-lite.hpp"
+#include "queue.hpp"
+#include "ring_allocator.hpp"
+#include "semaphore.hpp"
+#include "sync_helper.hpp"
+
+namespace vka {
+struct buffer_upload {
+  gsl::span<const gsl::byte> data;
+  VkBuffer destination = {};
+  VkDeviceSize offset = {};
+  ThsvsAccessType nextAccess =
+      THSVS_ACCESS_ANY_SHADER_READ_UNIFORM_BUFFER_OR_VERTEX_BUFFER;
+};
+
+struct image_upload {
+  gsl::span<const gsl::byte> data;
+  VkImage destination = {};
+  VkImageSubresourceLayers subresource = {
+      VK_IMAGE_ASPECT_COLOR_BIT, 0, 0, 1};
+  VkOffset3D offset = {};
+  VkExtent3D extent = {};
+  ThsvsAccessType nextAccess =
+      THSVS_ACCESS_ANY_SHADER_READ_SAMPLED_IMAGE_OR_UNIFORM_TEXEL_BUFFER;
+  // Access of the subresource before the upload. The
+  // default discards its contents, which is only right for
+  // a copy covering the whole subresource of an image
+  // without data.
+  ThsvsAccessType previousAccess = THSVS_ACCESS_NONE;
+};
+
+// Semaphore signaled by a submitted batch; the consuming
+// queue must wait on it before using the uploaded data.
+struct upload_batch {
+  VkSemaphore semaphore = {};
+  VkFence fence = {};
+};
+
+struct upload_manager {
+  static constexpr size_t batch_count = 2;
+
+  struct batch_slot {
+    std::unique_ptr<command_buffer> commandBuffer = {};
+    std::unique_ptr<fence> fencePtr = {};
+    std::unique_ptr<semaphore> semaphorePtr = {};
+  };
+
+  explicit upload_manager(
+      VkDevice device,
+      queue transferQueue,
+      uint32_t transferFamilyIndex,
+      uint32_t destinationFamilyIndex,
+      std::unique_ptr<command_pool> commandPool,
+      std::array<batch_slot, batch_count> slots,
+      std::unique_ptr<ring_allocator> staging)
+      : m_device(device),
+        m_queue(transferQueue),
+        m_transferFamilyIndex(transferFamilyIndex),
+        m_destinationFamilyIndex(destinationFamilyIndex),
+        m_commandPool(std::move(commandPool)),
+        m_slots(std::move(slots)),
+        m_staging(std::move(staging)) {}
+
+  upload_manager(const upload_manager&) = delete;
+  upload_manager(upload_manager&&) = default;
+  upload_manager& operator=(const upload_manager&) = delete;
+  upload_manager& operator=(upload_manager&&) = default;
+
+  ~upload_manager() noexcept {
+    if (!m_slots[0].fencePtr) {
+      return;
+    }
+    std::array<VkFence, batch_count> fences = {};
+    for (size_t i = {}; i < batch_count; ++i) {
+      fences[i] = *m_slots[i].fencePtr;
+    }
+    vkWaitForFences(
+        m_device,
+        static_cast<uint32_t>(fences.size()),
+        fences.data(),
+        VK_TRUE,
+        UINT64_MAX);
+  }
+
+  // Copies data into the staging buffer. The copy into the
+  // destination is recorded by the next submit().
+  tl::expected<void, ring_out_of_space> enqueue(
+      buffer_upload upload) {
+    m_staging->reclaim();
+    return m_staging
+        ->push(upload.data)
+        .map([&](ring_allocation allocation) {
+          m_bufferCopies.push_back(
+              {upload,
+               {allocation.offset,
+                upload.offset,
+                allocation.size}});
+        });
+  }
+
+  tl::expected<void, ring_out_of_space> enqueue(
+      image_upload upload) {
+    m_staging->reclaim();
+    return m_staging
+        ->push(upload.data)
+        .map([&](ring_allocation allocation) {
+          VkBufferImageCopy region = {};
+          region.bufferOffset = allocation.offset;
+          region.imageSubresource = upload.subresource;
+          region.imageOffset = upload.offset;
+          region.imageExtent = upload.extent;
+          m_imageCopies.push_back({upload, region});
+        });
+  }
+
+  bool empty() const noexcept {
+    return m_bufferCopies.empty() && m_imageCopies.empty();
+  }
+
+  // Records every pending copy into one command buffer and
+  // submits it on the transfer queue.
+  tl::expected<upload_batch, VkResult> submit() {
+    auto& slot = m_slots[m_nextSlot];
+    VkFence slotFence = *slot.fencePtr;
+    auto waitResult = vkWaitForFences(
+        m_device, 1, &slotFence, VK_TRUE, UINT64_MAX);
+    if (waitResult != VK_SUCCESS) {
+      return tl::make_unexpected(waitResult);
+    }
+    m_staging->reclaim();
+
+    VkCommandBuffer cmd = *slot.commandBuffer;
+    VkCommandBufferBeginInfo beginInfo = {
+        VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+    beginInfo.flags =
+        VK_COMMAND_BUFFER_USAGE_ONE_TIME_SUBMIT_BIT;
+    auto beginResult =
+        vkBeginCommandBuffer(cmd, &beginInfo);
+    if (beginResult != VK_SUCCESS) {
+      return tl::make_unexpected(beginResult);
+    }
+    std::vector<ownership_buffer> releaseBuffers = {};
+    std::vector<ownership_image> releaseImages = {};
+    record_copies(cmd, releaseBuffers, releaseImages);
+    auto endResult = vkEndCommandBuffer(cmd);
+    if (endResult != VK_SUCCESS) {
+      return tl::make_unexpected(endResult);
+    }
+
+    VkSemaphore signal = *slot.semaphorePtr;
+    VkSubmitInfo submitInfo = {
+        VK_STRUCTURE_TYPE_SUBMIT_INFO};
+    submitInfo.commandBufferCount = 1;
+    submitInfo.pCommandBuffers = &cmd;
+    submitInfo.signalSemaphoreCount = 1;
+    submitInfo.pSignalSemaphores = &signal;
+    auto resetResult =
+        vkResetFences(m_device, 1, &slotFence);
+    if (resetResult != VK_SUCCESS) {
+      return tl::make_unexpected(resetResult);
+    }
+    auto submitResult =
+        m_queue.submit({&submitInfo, 1}, slotFence);
+    if (!submitResult) {
+      // signal the fence again so that the next submit()
+      // and the destructor do not wait on it forever
+      m_queue.submit({}, slotFence);
+      return tl::make_unexpected(submitResult.error());
+    }
+    m_bufferCopies.clear();
+    m_imageCopies.clear();
+    if (ownership_transfer()) {
+      m_acquireBuffers.insert(
+          m_acquireBuffers.end(),
+          releaseBuffers.begin(),
+          releaseBuffers.end());
+      m_acquireImages.insert(
+          m_acquireImages.end(),
+          releaseImages.begin(),
+          releaseImages.end());
+    }
+    m_staging->end_frame(slotFence);
+    m_nextSlot = (m_nextSlot + 1) % batch_count;
+    return upload_batch{signal, slotFence};
+  }
+
+  // Records the queue family ownership acquire barriers for
+  // every batch submitted since the last call. Must be
+  // recorded on the destination queue family, in a
+  // submission that waits on the semaphores of those
+  // batches.
+  void record_acquire(VkCommandBuffer cmd) {
+    if (!ownership_transfer() ||
+        (m_acquireBuffers.empty() &&
+         m_acquireImages.empty())) {
+      return;
+    }
+    VkPipelineStageFlags dstStages = {};
+    std::vector<VkBufferMemoryBarrier> bufferBarriers = {};
+    std::vector<VkImageMemoryBarrier> imageBarriers = {};
+    for (auto& acquire : m_acquireBuffers) {
+      VkPipelineStageFlags src = {};
+      VkPipelineStageFlags dst = {};
+      VkBufferMemoryBarrier barrier = {};
+      thsvsGetVulkanBufferMemoryBarrier(
+          acquire.barrier(), &src, &dst, &barrier);
+      barrier.srcAccessMask = 0;
+      dstStages |= dst;
+      bufferBarriers.push_back(barrier);
+    }
+    for (auto& acquire : m_acquireImages) {
+      VkPipelineStageFlags src = {};
+      VkPipelineStageFlags dst = {};
+      VkImageMemoryBarrier barrier = {};
+      thsvsGetVulkanImageMemoryBarrier(
+          acquire.barrier(), &src, &dst, &barrier);
+      barrier.srcAccessMask = 0;
+      dstStages |= dst;
+      imageBarriers.push_back(barrier);
+    }
+    vkCmdPipelineBarrier(
+        cmd,
+        VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT,
+        dstStages,
+        0,
+        0,
+        nullptr,
+        static_cast<uint32_t>(bufferBarriers.size()),
+        bufferBarriers.data(),
+        static_cast<uint32_t>(imageBarriers.size()),
+        imageBarriers.data());
+    m_acquireBuffers.clear();
+    m_acquireImages.clear();
+  }
+
+  // Ownership transfers released by submitted batches that
+  // no record_acquire() has picked up yet.
+  size_t pending_acquires() const noexcept {
+    return m_acquireBuffers.size() + m_acquireImages.size();
+  }
+
+  bool ownership_transfer() const noexcept {
+    return m_transferFamilyIndex !=
+           m_destinationFamilyIndex;
+  }
+
+private:
+  struct pending_buffer_copy {
+    buffer_upload upload;
+    VkBufferCopy region;
+  };
+
+  struct pending_image_copy {
+    image_upload upload;
+    VkBufferImageCopy region;
+  };
+
+  struct ownership_buffer {
+    ThsvsAccessType prevAccess =
+        THSVS_ACCESS_TRANSFER_WRITE;
+    ThsvsAccessType nextAccess = {};
+    uint32_t srcFamily = {};
+    uint32_t dstFamily = {};
+    VkBuffer buffer = {};
+    VkDeviceSize offset = {};
+    VkDeviceSize size = {};
+
+    ThsvsBufferBarrier barrier() const noexcept {
+      return {1,
+              &prevAccess,
+              1,
+              &nextAccess,
+              srcFamily,
+              dstFamily,
+              buffer,
+              offset,
+              size};
+    }
+  };
+
+  struct ownership_image {
+    ThsvsAccessType prevAccess =
+        THSVS_ACCESS_TRANSFER_WRITE;
+    ThsvsAccessType nextAccess = {};
+    uint32_t srcFamily = {};
+    uint32_t dstFamily = {};
+    VkImage image = {};
+    VkImageSubresourceRange range = {};
+
+    ThsvsImageBarrier barrier() const noexcept {
+      return {1,
+              &prevAccess,
+              1,
+              &nextAccess,
+              THSVS_IMAGE_LAYOUT_OPTIMAL,
+              THSVS_IMAGE_LAYOUT_OPTIMAL,
+              VK_FALSE,
+              srcFamily,
+              dstFamily,
+              image,
+              range};
+    }
+  };
+
+  static VkImageSubresourceRange to_range(
+      VkImageSubresourceLayers layers) noexcept {
+    return {layers.aspectMask,
+            layers.mipLevel,
+            1,
+            layers.baseArrayLayer,
+            layers.layerCount};
+  }
+
+  // Pending copies are kept until their submission
+  // succeeds, so a failed submit() can be retried.
+  void record_copies(
+      VkCommandBuffer cmd,
+      std::vector<ownership_buffer>& releaseBuffers,
+      std::vector<ownership_image>& releaseImages) {
+    uint32_t srcFamily = VK_QUEUE_FAMILY_IGNORED;
+    uint32_t dstFamily = VK_QUEUE_FAMILY_IGNORED;
+    if (ownership_transfer()) {
+      srcFamily = m_transferFamilyIndex;
+      dstFamily = m_destinationFamilyIndex;
+    }
+
+    // previous access -> transfer destination for every
+    // image region before any copy is issued
+    static const ThsvsAccessType transferWrite =
+        THSVS_ACCESS_TRANSFER_WRITE;
+    std::vector<ThsvsImageBarrier> toTransfer = {};
+    for (auto& copy : m_imageCopies) {
+      ThsvsImageBarrier barrier = {};
+      auto& previous = copy.upload.previousAccess;
+      if (previous != THSVS_ACCESS_NONE) {
+        barrier.prevAccessCount = 1;
+        barrier.pPrevAccesses = &previous;
+      }
+      barrier.nextAccessCount = 1;
+      barrier.pNextAccesses = &transferWrite;
+      barrier.prevLayout = THSVS_IMAGE_LAYOUT_OPTIMAL;
+      barrier.nextLayout = THSVS_IMAGE_LAYOUT_OPTIMAL;
+      barrier.discardContents =
+          previous == THSVS_ACCESS_NONE ? VK_TRUE
+                                        : VK_FALSE;
+      barrier.srcQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.dstQueueFamilyIndex = VK_QUEUE_FAMILY_IGNORED;
+      barrier.image = copy.upload.destination;
+      barrier.subresourceRange =
+          to_range(copy.upload.subresource);
+      toTransfer.push_back(barrier);
+    }
+    if (!toTransfer.empty()) {
+      thsvsCmdPipelineBarrier(
+          cmd,
+          nullptr,
+          0,
+          nullptr,
+          static_cast<uint32_t>(toTransfer.size()),
+          toTransfer.data());
+    }
+
+    // one copy command per destination
+    std::stable_sort(
+        m_bufferCopies.begin(),
+        m_bufferCopies.end(),
+        [](auto& a, auto& b) {
+          return a.upload.destination <
+                 b.upload.destination;
+        });
+    std::vector<VkBufferCopy> bufferRegions = {};
+    for (size_t i = {}; i < m_bufferCopies.size(); ++i) {
+      auto& copy = m_bufferCopies[i];
+      bufferRegions.push_back(copy.region);
+      releaseBuffers.push_back(
+          {THSVS_ACCESS_TRANSFER_WRITE,
+           copy.upload.nextAccess,
+           srcFamily,
+           dstFamily,
+           copy.upload.destination,
+           copy.region.dstOffset,
+           copy.region.size});
+      auto last =
+          i + 1 == m_bufferCopies.size() ||
+          m_bufferCopies[i + 1].upload.destination !=
+              copy.upload.destination;
+      if (last) {
+        vkCmdCopyBuffer(
+            cmd,
+            *m_staging,
+            copy.upload.destination,
+            static_cast<uint32_t>(bufferRegions.size()),
+            bufferRegions.data());
+        bufferRegions.clear();
+      }
+    }
+
+    std::stable_sort(
+        m_imageCopies.begin(),
+        m_imageCopies.end(),
+        [](auto& a, auto& b) {
+          return a.upload.destination <
+                 b.upload.destination;
+        });
+    std::vector<VkBufferImageCopy> imageRegions = {};
+    for (size_t i = {}; i < m_imageCopies.size(); ++i) {
+      auto& copy = m_imageCopies[i];
+      imageRegions.push_back(copy.region);
+      releaseImages.push_back(
+          {THSVS_ACCESS_TRANSFER_WRITE,
+           copy.upload.nextAccess,
+           srcFamily,
+           dstFamily,
+           copy.upload.destination,
+           to_range(copy.upload.subresource)});
+      auto last =
+          i + 1 == m_imageCopies.size() ||
+          m_imageCopies[i + 1].upload.destination !=
+              copy.upload.destination;
+      if (last) {
+        vkCmdCopyBufferToImage(
+            cmd,
+            *m_staging,
+            copy.upload.destination,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            static_cast<uint32_t>(imageRegions.size()),
+            imageRegions.data());
+        imageRegions.clear();
+      }
+    }
+
+    record_release(cmd, releaseBuffers, releaseImages);
+  }
+
+  // With a dedicated transfer queue this is the release
+  // half of the ownership transfer; otherwise it is the
+  // ordinary transfer -> consumer barrier.
+  void record_release(
+      VkCommandBuffer cmd,
+      const std::vector<ownership_buffer>& releaseBuffers,
+      const std::vector<ownership_image>& releaseImages) {
+    if (releaseBuffers.empty() && releaseImages.empty()) {
+      return;
+    }
+    VkPipelineStageFlags srcStages = {};
+    VkPipelineStageFlags dstStages = {};
+    std::vector<VkBufferMemoryBarrier> bufferBarriers = {};
+    std::vector<VkImageMemoryBarrier> imageBarriers = {};
+    for (auto& release : releaseBuffers) {
+      VkPipelineStageFlags src = {};
+      VkPipelineStageFlags dst = {};
+      VkBufferMemoryBarrier barrier = {};
+      thsvsGetVulkanBufferMemoryBarrier(
+          release.barrier(), &src, &dst, &barrier);
+      srcStages |= src;
+      dstStages |= dst;
+      bufferBarriers.push_back(barrier);
+    }
+    for (auto& release : releaseImages) {
+      VkPipelineStageFlags src = {};
+      VkPipelineStageFlags dst = {};
+      VkImageMemoryBarrier barrier = {};
+      thsvsGetVulkanImageMemoryBarrier(
+          release.barrier(), &src, &dst, &barrier);
+      srcStages |= src;
+      dstStages |= dst;
+      imageBarriers.push_back(barrier);
+    }
+    if (ownership_transfer()) {
+      // the destination scope is ignored for a release,
+      // and a transfer-only queue may not support the
+      // consumer's stages
+      dstStages = VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT;
+      for (auto& barrier : bufferBarriers) {
+        barrier.dstAccessMask = 0;
+      }
+      for (auto& barrier : imageBarriers) {
+        barrier.dstAccessMask = 0;
+      }
+    }
+    vkCmdPipelineBarrier(
+        cmd,
+        srcStages,
+        dstStages,
+        0,
+        0,
+        nullptr,
+        static_cast<uint32_t>(bufferBarriers.size()),
+        bufferBarriers.data(),
+        static_cast<uint32_t>(imageBarriers.size()),
+        imageBarriers.data());
+  }
+
+  VkDevice m_device = {};
+  queue m_queue = {};
+  uint32_t m_transferFamilyIndex = {};
+  uint32_t m_destinationFamilyIndex = {};
+  std::unique_ptr<command_pool> m_commandPool = {};
+  std::array<batch_slot, batch_count> m_slots = {};
+  std::unique_ptr<ring_allocator> m_staging = {};
+  size_t m_nextSlot = {};
+  std::vector<pending_buffer_copy> m_bufferCopies = {};
+  std::vector<pending_image_copy> m_imageCopies = {};
+  std::vector<ownership_buffer> m_acquireBuffers = {};
+  std::vector<ownership_image> m_acquireImages = {};
+};
+
+struct upload_manager_builder {
+  tl::expected<std::unique_ptr<upload_manager>, VkResult>
+  build(VkDevice device, VmaAllocator allocator) {
+    std::unique_ptr<command_pool> poolPtr = {};
+    auto poolResult =
+        command_pool_builder{}
+            .queue_family_index(m_transferFamilyIndex)
+            .allow_buffer_reset()
+            .build(device);
+    if (!poolResult) {
+      return tl::make_unexpected(poolResult.error());
+    }
+    poolPtr = std::move(*poolResult);
+
+    std::array<upload_manager::batch_slot,
+               upload_manager::batch_count>
+        slots = {};
+    for (auto& slot : slots) {
+      auto commandResult =
+          command_buffer_allocator{}
+              .set_command_pool(poolPtr.get())
+              .allocate(device);
+      if (!commandResult) {
+        return tl::make_unexpected(commandResult.error());
+      }
+      slot.commandBuffer = std::move(*commandResult);
+
+      auto fenceResult =
+          fence_builder{}.signaled().build(device);
+      if (!fenceResult) {
+        return tl::make_unexpected(fenceResult.error());
+      }
+      slot.fencePtr = std::move(*fenceResult);
+
+      auto semaphoreResult =
+          semaphore_builder{}.build(device);
+      if (!semaphoreResult) {
+        return tl::make_unexpected(semaphoreResult.error());
+      }
+      slot.semaphorePtr = std::move(*semaphoreResult);
+    }
+
+    auto stagingResult =
+        ring_allocator_builder{}
+            .size(m_stagingSize)
+            .min_alignment(m_stagingAlignment)
+            .transfer_source()
+            .queue_family_index(m_transferFamilyIndex)
+            .build(device, allocator);
+    if (!stagingResult) {
+      return tl::make_unexpected(stagingResult.error());
+    }
+
+    return std::make_unique<upload_manager>(
+        device,
+        m_transferQueue,
+        m_transferFamilyIndex,
+        m_destinationFamilyIndex,
+        std::move(poolPtr),
+        std::move(slots),
+        std::move(*stagingResult));
+  }
+
+  upload_manager_builder& staging_size(VkDeviceSize size) {
+    m_stagingSize = size;
+    return *this;
+  }
+
+  // Alignment of each region in the staging buffer, e.g.
+  // optimalBufferCopyOffsetAlignment.
+  upload_manager_builder& staging_alignment(
+      VkDeviceSize alignment) {
+    m_stagingAlignment = alignment;
+    return *this;
+  }
+
+  // The transfer queue is normally obtained from a family
+  // selected with
+  // queue_family_builder::dedicated_transfer().
+  upload_manager_builder& transfer_queue(
+      queue transferQueue,
+      uint32_t familyIndex) {
+    m_transferQueue = transferQueue;
+    m_transferFamilyIndex = familyIndex;
+    return *this;
+  }
+
+  // The queue family that consumes the uploaded resources.
+  upload_manager_builder& destination_family_index(
+      uint32_t familyIndex) {
+    m_destinationFamilyIndex = familyIndex;
+    return *this;
+  }
+
+private:
+  VkDeviceSize m_stagingSize = {};
+  VkDeviceSize m_stagingAlignment = 16;
+  queue m_transferQueue = {};
+  uint32_t m_transferFamilyIndex = {};
+  uint32_t m_destinationFamilyIndex = {};
+};
+}  // namespace vka
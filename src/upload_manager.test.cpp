@@ -0,0 +1,250 @@
+#include "upload_manager.hpp"
+
+#include <array>
+#include <catch2/catch.hpp>
+#include "buffer.hpp"
+#include "command_buffer.hpp"
+#include "command_pool.hpp"
+#include "device.hpp"
+#include "instance.hpp"
+#include "memory_allocator.hpp"
+#include "move_into.hpp"
+#include "physical_device.hpp"
+#include "platform_glfw.hpp"
+#include "queue.hpp"
+#include "queue_family.hpp"
+
+using namespace vka;
+TEST_CASE("Upload a buffer on a transfer queue") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family graphicsFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{graphicsFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family transferFamily = graphicsFamily;
+  queue_family_builder{}
+      .dedicated_transfer()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{transferFamily});
+
+  auto deviceBuilder = device_builder{};
+  deviceBuilder.add_queue_family(graphicsFamily);
+  if (transferFamily.familyIndex !=
+      graphicsFamily.familyIndex) {
+    deviceBuilder.add_queue_family(transferFamily);
+  }
+  std::unique_ptr<device> devicePtr = {};
+  deviceBuilder.physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue transferQueue = {};
+  queue_builder{}
+      .queue_info(transferFamily, 0)
+      .build(*devicePtr)
+      .map(move_into{transferQueue})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<buffer> bufferPtr = {};
+  buffer_builder{}
+      .size(1024)
+      .gpu_only()
+      .vertex_buffer()
+      .transfer_destination()
+      .queue_family_index(graphicsFamily.familyIndex)
+      .build(*allocatorPtr)
+      .map(move_into{bufferPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<upload_manager> uploadPtr = {};
+  upload_manager_builder{}
+      .staging_size(4096)
+      .transfer_queue(
+          transferQueue, transferFamily.familyIndex)
+      .destination_family_index(graphicsFamily.familyIndex)
+      .build(*devicePtr, *allocatorPtr)
+      .map(move_into{uploadPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::array<float, 6> vertices = {
+      0.f, 0.f, 1.f, 0.f, 0.f, 1.f};
+  buffer_upload upload = {};
+  upload.data = gsl::as_bytes(gsl::span<float>(vertices));
+  upload.destination = *bufferPtr;
+  REQUIRE(uploadPtr->enqueue(upload));
+  REQUIRE(!uploadPtr->empty());
+
+  upload_batch batch = {};
+  uploadPtr->submit()
+      .map(move_into{batch})
+      .map_error([](auto error) { REQUIRE(false); });
+  REQUIRE(uploadPtr->empty());
+  REQUIRE(batch.semaphore != VK_NULL_HANDLE);
+  REQUIRE(
+      vkWaitForFences(
+          *devicePtr,
+          1,
+          &batch.fence,
+          VK_TRUE,
+          UINT64_MAX) == VK_SUCCESS);
+}
+
+TEST_CASE("Acquire uploads from several batches at once") {
+  platform::glfw::init();
+  std::unique_ptr<instance> instancePtr = {};
+  instance_builder{}
+      .add_layer(standard_validation)
+      .build()
+      .map(move_into{instancePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkPhysicalDevice physicalDevice = {};
+  physical_device_selector{}
+      .select(*instancePtr)
+      .map(move_into{physicalDevice})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family graphicsFamily = {};
+  queue_family_builder{}
+      .graphics_support()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{graphicsFamily})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue_family transferFamily = graphicsFamily;
+  queue_family_builder{}
+      .dedicated_transfer()
+      .queue(1.f)
+      .build(physicalDevice)
+      .map(move_into{transferFamily});
+
+  auto deviceBuilder = device_builder{};
+  deviceBuilder.add_queue_family(graphicsFamily);
+  if (transferFamily.familyIndex !=
+      graphicsFamily.familyIndex) {
+    deviceBuilder.add_queue_family(transferFamily);
+  }
+  std::unique_ptr<device> devicePtr = {};
+  deviceBuilder.physical_device(physicalDevice)
+      .build(*instancePtr)
+      .map(move_into{devicePtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<allocator> allocatorPtr = {};
+  allocator_builder{}
+      .physical_device(physicalDevice)
+      .device(*devicePtr)
+      .build()
+      .map(move_into{allocatorPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  queue transferQueue = {};
+  queue_builder{}
+      .queue_info(transferFamily, 0)
+      .build(*devicePtr)
+      .map(move_into{transferQueue})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<buffer> bufferPtr = {};
+  buffer_builder{}
+      .size(1024)
+      .gpu_only()
+      .vertex_buffer()
+      .transfer_destination()
+      .queue_family_index(graphicsFamily.familyIndex)
+      .build(*allocatorPtr)
+      .map(move_into{bufferPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<upload_manager> uploadPtr = {};
+  upload_manager_builder{}
+      .staging_size(4096)
+      .transfer_queue(
+          transferQueue, transferFamily.familyIndex)
+      .destination_family_index(graphicsFamily.familyIndex)
+      .build(*devicePtr, *allocatorPtr)
+      .map(move_into{uploadPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::array<float, 6> vertices = {
+      0.f, 0.f, 1.f, 0.f, 0.f, 1.f};
+  buffer_upload upload = {};
+  upload.data = gsl::as_bytes(gsl::span<float>(vertices));
+  upload.destination = *bufferPtr;
+  REQUIRE(uploadPtr->enqueue(upload));
+  REQUIRE(!uploadPtr->empty());
+
+  upload_batch first = {};
+  uploadPtr->submit()
+      .map(move_into{first})
+      .map_error([](auto error) { REQUIRE(false); });
+  upload.offset = 512;
+  REQUIRE(uploadPtr->enqueue(upload));
+  upload_batch second = {};
+  uploadPtr->submit()
+      .map(move_into{second})
+      .map_error([](auto error) { REQUIRE(false); });
+  auto expected = uploadPtr->ownership_transfer() ? 2 : 0;
+  REQUIRE(uploadPtr->pending_acquires() == expected);
+
+  std::unique_ptr<command_pool> commandPoolPtr = {};
+  command_pool_builder{}
+      .queue_family_index(graphicsFamily.familyIndex)
+      .build(*devicePtr)
+      .map(move_into{commandPoolPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  std::unique_ptr<command_buffer> commandPtr = {};
+  command_buffer_allocator{}
+      .set_command_pool(commandPoolPtr.get())
+      .allocate(*devicePtr)
+      .map(move_into{commandPtr})
+      .map_error([](auto error) { REQUIRE(false); });
+
+  VkCommandBufferBeginInfo beginInfo = {
+      VK_STRUCTURE_TYPE_COMMAND_BUFFER_BEGIN_INFO};
+  REQUIRE(
+      vkBeginCommandBuffer(*commandPtr, &beginInfo) ==
+      VK_SUCCESS);
+  uploadPtr->record_acquire(*commandPtr);
+  REQUIRE(vkEndCommandBuffer(*commandPtr) == VK_SUCCESS);
+  REQUIRE(uploadPtr->pending_acquires() == 0);
+
+  std::array<VkFence, 2> fences = {
+      first.fence, second.fence};
+  REQUIRE(
+      vkWaitForFences(
+          *devicePtr,
+          2,
+          fences.data(),
+          VK_TRUE,
+          UINT64_MAX) == VK_SUCCESS);
+}
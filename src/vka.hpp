@@ -1,24 +1,47 @@
 #pragma once
 
+#include "async_build.hpp"
+#include "barrier_batcher.hpp"
 #include "buffer.hpp"
+#include "buffer_suballocator.hpp"
 #include "command_buffer.hpp"
 #include "command_pool.hpp"
+#include "command_pool_manager.hpp"
+#include "command_recorder.hpp"
+#include "defragmenter.hpp"
+#include "deletion_queue.hpp"
 #include "descriptor_pool.hpp"
 #include "descriptor_set.hpp"
 #include "descriptor_set_layout.hpp"
 #include "device.hpp"
+#include "draw_queue.hpp"
+#include "event.hpp"
 #include "fence.hpp"
+#include "fence_waiter.hpp"
+#include "frame_context.hpp"
 #include "framebuffer.hpp"
 #include "image.hpp"
 #include "image_view.hpp"
+#include "indirect_batcher.hpp"
 #include "instance.hpp"
+#include "parallel_recorder.hpp"
 #include "physical_device.hpp"
 #include "pipeline.hpp"
 #include "pipeline_layout.hpp"
 #include "queue.hpp"
 #include "queue_family.hpp"
+#include "render_graph.hpp"
 #include "render_pass.hpp"
+#include "resource_tracker.hpp"
+#include "ring_allocator.hpp"
 #include "semaphore.hpp"
 #include "shader_module.hpp"
+#include "split_barrier.hpp"
+#include "submit_batcher.hpp"
 #include "surface.hpp"
-#include "swapchain.hpp"
\ No newline at end of file
+#include "swapchain.hpp"
+#include "timeline_graph.hpp"
+#include "timeline_semaphore.hpp"
+#include "upload_manager.hpp"
+#include "work_stealing_pool.hpp"
+#include "worker_pool.hpp"
\ No newline at end of file
@@ -0,0 +1,153 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace vka {
+// Runs indexed tasks across a fixed set of workers. Each
+// worker drains its own queue from the back and steals
+// from the front of the others' when it runs dry. The
+// thread calling parallel_for() takes part as worker 0.
+struct work_stealing_pool {
+  using task_body = std::function<
+      void(uint32_t workerIndex, size_t task)>;
+
+  // A workerCount of 0 is treated as 1, the calling thread.
+  explicit work_stealing_pool(uint32_t workerCount) {
+    workerCount = std::max(workerCount, uint32_t(1));
+    for (uint32_t i = {}; i < workerCount; ++i) {
+      m_queues.push_back(std::make_unique<task_queue>());
+    }
+    for (uint32_t i = 1; i < workerCount; ++i) {
+      m_threads.emplace_back([this, i] { run(i); });
+    }
+  }
+
+  work_stealing_pool(const work_stealing_pool&) = delete;
+  work_stealing_pool(work_stealing_pool&&) = delete;
+  work_stealing_pool& operator=(const work_stealing_pool&) =
+      delete;
+  work_stealing_pool& operator=(work_stealing_pool&&) =
+      delete;
+
+  ~work_stealing_pool() noexcept {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads) {
+      thread.join();
+    }
+  }
+
+  // Blocks until body has run for every task index. Must
+  // not be called concurrently.
+  void parallel_for(size_t taskCount, task_body body) {
+    if (taskCount == 0) {
+      return;
+    }
+    m_body = std::move(body);
+    m_remaining = taskCount;
+    for (size_t task = {}; task < taskCount; ++task) {
+      auto& queue = *m_queues[task % m_queues.size()];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      queue.tasks.push_back(task);
+    }
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      ++m_generation;
+    }
+    m_wake.notify_all();
+
+    work(0);
+    std::unique_lock<std::mutex> lock(m_mutex);
+    m_done.wait(lock, [this] { return m_remaining == 0; });
+  }
+
+  uint32_t worker_count() const noexcept {
+    return static_cast<uint32_t>(m_queues.size());
+  }
+
+private:
+  struct task_queue {
+    std::mutex mutex = {};
+    std::deque<size_t> tasks = {};
+  };
+
+  void run(uint32_t workerIndex) {
+    uint64_t seenGeneration = {};
+    for (;;) {
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [&] {
+          return m_stopping ||
+                 m_generation != seenGeneration;
+        });
+        if (m_stopping) {
+          return;
+        }
+        seenGeneration = m_generation;
+      }
+      work(workerIndex);
+    }
+  }
+
+  void work(uint32_t workerIndex) {
+    size_t task = {};
+    while (pop(workerIndex, task) ||
+           steal(workerIndex, task)) {
+      m_body(workerIndex, task);
+      if (--m_remaining == 0) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_done.notify_all();
+      }
+    }
+  }
+
+  bool pop(uint32_t workerIndex, size_t& task) {
+    auto& queue = *m_queues[workerIndex];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    if (queue.tasks.empty()) {
+      return false;
+    }
+    task = queue.tasks.back();
+    queue.tasks.pop_back();
+    return true;
+  }
+
+  bool steal(uint32_t workerIndex, size_t& task) {
+    for (size_t offset = 1; offset < m_queues.size();
+         ++offset) {
+      auto victim =
+          (workerIndex + offset) % m_queues.size();
+      auto& queue = *m_queues[victim];
+      std::lock_guard<std::mutex> lock(queue.mutex);
+      if (!queue.tasks.empty()) {
+        task = queue.tasks.front();
+        queue.tasks.pop_front();
+        return true;
+      }
+    }
+    return false;
+  }
+
+  std::vector<std::unique_ptr<task_queue>> m_queues = {};
+  task_body m_body = {};
+  std::atomic<size_t> m_remaining = {};
+  std::mutex m_mutex = {};
+  std::condition_variable m_wake = {};
+  std::condition_variable m_done = {};
+  uint64_t m_generation = {};
+  bool m_stopping = {};
+  std::vector<std::thread> m_threads = {};
+};
+}  // namespace vka
@@ -0,0 +1,67 @@
+#include "work_stealing_pool.hpp"
+
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <vector>
+
+using namespace vka;
+TEST_CASE("Work stealing pool runs every task once") {
+  work_stealing_pool workers{4};
+  std::vector<std::atomic<int>> runs(1000);
+  workers.parallel_for(
+      runs.size(),
+      [&](uint32_t workerIndex, size_t task) {
+        ++runs[task];
+      });
+  for (auto& count : runs) {
+    REQUIRE(count == 1);
+  }
+}
+
+TEST_CASE("Work stealing pool reports worker indices") {
+  work_stealing_pool workers{3};
+  REQUIRE(workers.worker_count() == 3);
+  std::atomic<bool> outOfRange = {};
+  workers.parallel_for(
+      100, [&](uint32_t workerIndex, size_t task) {
+        if (workerIndex >= 3) {
+          outOfRange = true;
+        }
+      });
+  REQUIRE(!outOfRange);
+}
+
+TEST_CASE("Work stealing pool can be reused") {
+  work_stealing_pool workers{2};
+  std::atomic<size_t> total = {};
+  for (int round = {}; round < 50; ++round) {
+    workers.parallel_for(
+        10, [&](uint32_t workerIndex, size_t task) {
+          total += task;
+        });
+  }
+  REQUIRE(total == 50 * 45);
+}
+
+TEST_CASE("Single worker pool runs on the caller") {
+  work_stealing_pool workers{1};
+  auto caller = std::this_thread::get_id();
+  bool onCaller = true;
+  workers.parallel_for(
+      5, [&](uint32_t workerIndex, size_t task) {
+        onCaller = onCaller &&
+                   std::this_thread::get_id() == caller;
+      });
+  REQUIRE(onCaller);
+}
+
+TEST_CASE("Work stealing pool without workers runs inline") {
+  work_stealing_pool workers{0};
+  REQUIRE(workers.worker_count() == 1);
+  size_t total = {};
+  workers.parallel_for(
+      10, [&](uint32_t workerIndex, size_t task) {
+        total += task;
+      });
+  REQUIRE(total == 45);
+}
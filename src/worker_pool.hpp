@@ -0,0 +1,94 @@
+#pragma once
+
+#include <algorithm>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace vka {
+// Fixed set of threads running queued tasks in FIFO order.
+struct worker_pool {
+  // A threadCount of 0 is treated as 1.
+  explicit worker_pool(
+      size_t threadCount = default_count()) {
+    threadCount = std::max(threadCount, size_t(1));
+    for (size_t i = {}; i < threadCount; ++i) {
+      m_threads.emplace_back([this] { run(); });
+    }
+  }
+
+  worker_pool(const worker_pool&) = delete;
+  worker_pool(worker_pool&&) = delete;
+  worker_pool& operator=(const worker_pool&) = delete;
+  worker_pool& operator=(worker_pool&&) = delete;
+
+  // Finishes every queued task before joining.
+  ~worker_pool() noexcept {
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_stopping = true;
+    }
+    m_wake.notify_all();
+    for (auto& thread : m_threads) {
+      thread.join();
+    }
+  }
+
+  template <typename F>
+  auto submit(F task)
+      -> std::future<std::invoke_result_t<F>> {
+    using result_type = std::invoke_result_t<F>;
+    auto packaged =
+        std::make_shared<std::packaged_task<result_type()>>(
+            std::move(task));
+    auto future = packaged->get_future();
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_tasks.emplace_back([packaged] { (*packaged)(); });
+    }
+    m_wake.notify_one();
+    return future;
+  }
+
+  size_t thread_count() const noexcept {
+    return m_threads.size();
+  }
+
+  static size_t default_count() noexcept {
+    auto hardwareCount = static_cast<size_t>(
+        std::thread::hardware_concurrency());
+    return std::max<size_t>(hardwareCount, 2) - 1;
+  }
+
+private:
+  void run() {
+    for (;;) {
+      std::function<void()> task = {};
+      {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wake.wait(lock, [this] {
+          return m_stopping || !m_tasks.empty();
+        });
+        if (m_tasks.empty()) {
+          return;
+        }
+        task = std::move(m_tasks.front());
+        m_tasks.pop_front();
+      }
+      task();
+    }
+  }
+
+  std::mutex m_mutex = {};
+  std::condition_variable m_wake = {};
+  std::deque<std::function<void()>> m_tasks = {};
+  bool m_stopping = {};
+  std::vector<std::thread> m_threads = {};
+};
+}  // namespace vka
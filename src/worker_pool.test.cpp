@@ -0,0 +1,41 @@
+#include "worker_pool.hpp"
+
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <memory>
+#include <vector>
+
+using namespace vka;
+TEST_CASE("Worker pool returns task results") {
+  worker_pool workers{2};
+  auto future = workers.submit([] { return 42; });
+  REQUIRE(future.get() == 42);
+}
+
+TEST_CASE("Worker pool runs move-only results") {
+  worker_pool workers{1};
+  auto future = workers.submit(
+      [] { return std::make_unique<int>(7); });
+  auto result = future.get();
+  REQUIRE(result);
+  REQUIRE(*result == 7);
+}
+
+TEST_CASE("Worker pool finishes queued tasks on exit") {
+  std::atomic<int> count = {};
+  {
+    worker_pool workers{3};
+    for (int i = {}; i < 100; ++i) {
+      workers.submit([&count] { ++count; });
+    }
+  }
+  REQUIRE(count == 100);
+}
+
+TEST_CASE("Worker pool has at least one thread") {
+  REQUIRE(worker_pool::default_count() >= 1);
+
+  worker_pool workers{0};
+  REQUIRE(workers.thread_count() == 1);
+  REQUIRE(workers.submit([] { return 7; }).get() == 7);
+}